@@ -53,8 +53,8 @@ public class PixoDocumentation : ModuleRules
 				"BlueprintGraph",
 				"ImageWrapper",
 				"RenderCore",		//needed for UE5.1+
+				"Json",			//shard state
 				//"HTTP",
-				//"Json",
 				//"RHI",
 				//"Launch"
 				// ... add private dependencies that you statically link with here ...	
@@ -2,41 +2,148 @@
 
 #include "DocUtils.h"
 
+#include "GameFramework/Actor.h"
 #include "Misc/DefaultValueHelper.h"
 #include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
 
-#include "Internationalization/Regex.h"
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#endif
 
 #include <string>
 using namespace std;
 
 using namespace DocUtils;
 
+//the entities are for: < > & " ' and anything past ascii
+static FORCEINLINE bool needsEntity(TCHAR c)
+{
+	return c == '<' || c == '>' || c == '&' || c == '"' || c == '\'' || c > 127;
+}
+
+//the length of the entity for c, eg: 5 for &#39;
+static int32 entityLength(TCHAR c)
+{
+	switch (c)
+	{
+	case '<':	return 4;	//&lt;
+	case '>':	return 4;	//&gt;
+	case '&':	return 5;	//&amp;
+	case '"':	return 6;	//&quot;
+	case '\'':	return 5;	//&#39;
+	}
+
+	int32 digits = 1;
+	for (uint32 v = (uint32)c; v >= 10; v /= 10)
+		digits++;
+
+	return 3 + digits;	//&#...;
+}
+
+static void appendEntity(FString& out, TCHAR c)
+{
+	switch (c)
+	{
+	case '<':	out += TEXT("&lt;");	return;
+	case '>':	out += TEXT("&gt;");	return;
+	case '&':	out += TEXT("&amp;");	return;
+	case '"':	out += TEXT("&quot;");	return;
+	}
+
+	//&#[decimal]; , written backwards
+	TCHAR buf[16];
+	int32 n = UE_ARRAY_COUNT(buf);
+	buf[--n] = ';';
+	uint32 v = (uint32)c;
+	do
+	{
+		buf[--n] = '0' + v % 10;
+		v /= 10;
+	} while (v);
+	buf[--n] = '#';
+	buf[--n] = '&';
+
+	out.AppendChars(buf + n, UE_ARRAY_COUNT(buf) - n);
+}
+
+//the first character from start that needs an entity, or len
+static int32 findEntity(const TCHAR* s, int32 start, int32 len)
+{
+	int32 i = start;
+
+#if PLATFORM_CPU_X86_FAMILY
+	//eight UTF-16 characters at a time
+	if (sizeof(TCHAR) == 2)
+	{
+		const __m128i lt = _mm_set1_epi16('<');
+		const __m128i gt = _mm_set1_epi16('>');
+		const __m128i amp = _mm_set1_epi16('&');
+		const __m128i quot = _mm_set1_epi16('"');
+		const __m128i apos = _mm_set1_epi16('\'');
+		const __m128i high = _mm_set1_epi16((int16)0xFF80);		//any of these bits is past ascii
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; i + 8 <= len; i += 8)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+
+			__m128i hit = _mm_or_si128(_mm_cmpeq_epi16(v, lt), _mm_cmpeq_epi16(v, gt));
+			hit = _mm_or_si128(hit, _mm_cmpeq_epi16(v, amp));
+			hit = _mm_or_si128(hit, _mm_cmpeq_epi16(v, quot));
+			hit = _mm_or_si128(hit, _mm_cmpeq_epi16(v, apos));
+			hit = _mm_or_si128(hit, _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(v, high), zero), _mm_set1_epi16(-1)));
+
+			uint32 mask = (uint32)_mm_movemask_epi8(hit);
+			if (mask)
+				return i + (int32)(FMath::CountTrailingZeros(mask) / 2);
+		}
+	}
+#endif
+
+	for (; i < len; i++)
+		if (needsEntity(s[i]))
+			return i;
+
+	return len;
+}
+
+/**
+ * @brief Escape a string for html (and dot's html labels).
+ * @param in The string
+ * @return ..with entities for < > & " ' and each non-ascii character.
+ *
+ * Most strings need nothing, and are returned as they are.  Otherwise the
+ * output is sized first, then the clean runs between entities are copied
+ * whole.  Each UTF-16 unit gets its own numeric entity.
+ */
+
 FString DocUtils::htmlentities(FString in)
 {
-	//TArray<int> reps = { 34,39,60,61,62 };	// " ' < = >
-	TArray<int> reps = { 34,39 };	// " '
+	const TCHAR* s = *in;
+	int32 len = in.Len();
+
+	int32 i = findEntity(s, 0, len);
+	if (i == len)
+		return in;
+
+	int32 size = len;
+	for (int32 j = i; j < len; j = findEntity(s, j + 1, len))
+		size += entityLength(s[j]) - 1;
 
 	FString out;
-	for (int i = 0; i < in.Len(); i++)
+	out.Reserve(size);
+
+	int32 start = 0;
+	while (i < len)
 	{
-		if (in[i] == '>')
-			out += TEXT("&gt;");
-		else if (in[i] == '<')
-			out += TEXT("&lt;");
-		//else if (in[i] == '=')
-		//	out += TEXT("&equals;");
-		else if (in[i] == '&')
-			out += TEXT("&amp;");
-		else if (in[i] == '"')			//34
-			out += TEXT("&quot;");
-		else if (reps.Contains(in[i]))
-			out += FString::Printf(TEXT("&#%d;"), (int)in[i]);
-		else if (in[i] > 127)
-			out += FString::Printf(TEXT("&#%d;"), (int)in[i]);
-		else
-			out += in[i];
+		out.AppendChars(s + start, i - start);
+		appendEntity(out, s[i]);
+
+		start = i + 1;
+		i = findEntity(s, start, len);
 	}
+	out.AppendChars(s + start, len - start);
 
 	return out;
 }
@@ -93,35 +200,91 @@ void DocUtils::HSLtoRGB(float H, float S, float L, float* r, float* g, float* b)
 	*b = bp + m;
 }
 
-FString DocUtils::createColorString(FLinearColor color, float alpha, float exponent)
+/**
+ * @brief Our site's color adjustment, for many colors at once.
+ * @param in The colors.  Only RGB is used.
+ * @param out ..adjusted.  Alpha is left alone.
+ * @param num How many
+ * @param exponent Our gamma correct
+ *
+ * The same as RGBtoHSL(), a hue rotation of 180, a gamma correct of the
+ * lightness, and HSLtoRGB(), with the same arithmetic, so results match to
+ * the bit.  The branches are selects, and HSLtoRGB's six sectors are a
+ * table of which channel gets C, X or 0.
+ */
+
+void DocUtils::convertColors(FLinearColor const* in, FLinearColor* out, int32 num, float exponent)
 {
-	//return "#"+color.ToFColor(true).ToHex();
-
-	float R, G, B;
-	float H, S, L;
-
-	R = color.R;
-	G = color.G;
-	B = color.B;
-
-//	printf("in: %0.2f %0.2f %0.2f ", R, G, B);
-
-	RGBtoHSL(R, G, B, &H, &S, &L);
+	//the channel that gets C, X and 0 (as 0, 1, 2) for R, G, B, in each sector of 60 degrees
+	static const uint8 roles[6][3] = { {0,1,2}, {1,0,2}, {2,0,1}, {2,1,0}, {1,2,0}, {0,2,1} };
+	const float epsilon = 0.0001;
+	const float gamma = 1 / exponent;
 
-//	printf("hsl: %0.2f %0.2f %0.2f ", H, S, L);
+	for (int32 i = 0; i < num; i++)
+	{
+		float R = in[i].R;
+		float G = in[i].G;
+		float B = in[i].B;
+
+		float Cmax = fmax(R, fmax(G, B));
+		float Cmin = fmin(R, fmin(G, B));
+		float D = Cmax - Cmin;
+		bool flat = D < epsilon;
+
+		//all three, then pick one.  D may be 0, but then none are picked.
+		float HR = 60.0f * fmod(((G - B) / D), 6.0f);
+		float HG = 60.0f * (2.0f + ((B - R) / D));
+		float HB = 60.0f * (4.0f + ((R - G) / D));
+		float H = flat ? 0.0f : (Cmax == R) ? HR : (Cmax == G) ? HG : HB;
+
+		float L = (Cmax + Cmin) / 2.0f;
+		float S = flat ? 0.0f : D / (1 - fabs(2.0f * L - 1.0f));
+
+		H = fmod(H + 180.0f, 360.0f);	// our hue rotation for the site
+		L = powf(L, gamma);		// our gamma correct
+
+		float c = (1.0f - fabs(2.0f * L - 1)) * S;
+		float x = c * (1 - fabs(fmod(H / 60.0f, 2.0f) - 1.0f));
+		float m = L - c / 2.0f;
+
+		//as HSLtoRGB's if/else chain, where anything not under 300 (even NaN) is the last sector
+		int32 sector = 5 - (H < 60.0f) - (H < 120.0f) - (H < 180.0f) - (H < 240.0f) - (H < 300.0f);
+
+		const float cx0[3] = { c, x, 0 };
+		out[i].R = cx0[roles[sector][0]] + m;
+		out[i].G = cx0[roles[sector][1]] + m;
+		out[i].B = cx0[roles[sector][2]] + m;
+	}
+}
 
-	H = fmod(H + 180.0f, 360.0f);	// our hue rotation for the site
+//the exact bits of a color and its parameters, for the createColorString() memo
+struct colorKey
+{
+	uint32 bits[5];
 
-	//L = powf(L, 2.2f);			// to sRGB
-	L = powf(L, 1/exponent);		// our gamma correct
+	colorKey(FLinearColor const& color, float alpha, float exponent)
+	{
+		const float f[5] = { color.R, color.G, color.B, alpha, exponent };
+		FMemory::Memcpy(bits, f, sizeof(bits));
+	}
 
-	HSLtoRGB(H, S, L, &R, &G, &B);
+	bool operator==(colorKey const& other) const
+	{
+		return FMemory::Memcmp(bits, other.bits, sizeof(bits)) == 0;
+	}
 
-	FLinearColor rgb(R, G, B, alpha);
+	friend uint32 GetTypeHash(colorKey const& key)
+	{
+		return FCrc::MemCrc32(key.bits, sizeof(key.bits));
+	}
+};
 
-//	printf("rgb: %0.2f %0.2f %0.2f ", rgb.R, rgb.G, rgb.B);
-//	printf("\n");
+static TMap<colorKey, FString> ColorStrings;
+static FCriticalSection ColorStringsLock;
 
+static FString formatColorString(FLinearColor rgb, float alpha)
+{
+	rgb.A = alpha;
 	rgb = rgb.GetClamped();
 
 	FString c = "#" + rgb.ToFColor(true).ToHex();
@@ -132,6 +295,94 @@ FString DocUtils::createColorString(FLinearColor color, float alpha, float expon
 	return c;
 }
 
+/**
+ * @brief A color, adjusted for our site, as html.
+ * @param color The color.  Its alpha is ignored.
+ * @param alpha ..the alpha to use instead
+ * @param exponent Our gamma correct
+ *
+ * A project only has a handful of colors, so each one is worked out once,
+ * and remembered.  See createColorStrings() for a graph's worth at once.
+ */
+
+FString DocUtils::createColorString(FLinearColor color, float alpha, float exponent)
+{
+	//return "#"+color.ToFColor(true).ToHex();
+
+	colorKey key(color, alpha, exponent);
+
+	{
+		FScopeLock scope(&ColorStringsLock);
+		if (const FString* c = ColorStrings.Find(key))
+			return *c;
+	}
+
+	FLinearColor rgb;
+	convertColors(&color, &rgb, 1, exponent);
+	FString c = formatColorString(rgb, alpha);
+
+	FScopeLock scope(&ColorStringsLock);
+	ColorStrings.Add(key, c);
+
+	return c;
+}
+
+/**
+ * @brief createColorString(), for many colors at once.
+ * @param colors The colors
+ * @param strings ..as html, in the same order
+ *
+ * The colors that haven't been seen before are converted together, each
+ * only once however often it repeats.
+ */
+
+void DocUtils::createColorStrings(TArray<FLinearColor> const& colors, TArray<FString>& strings, float alpha, float exponent)
+{
+	strings.SetNum(colors.Num());
+
+	TArray<int32> missing;			//into colors, for each color in `in`
+	TArray<FLinearColor> in;
+	TMap<colorKey, int32> pending;		//..and back, for the repeats
+	TArray<TPair<int32, int32>> repeats;	//colors index, in index
+	{
+		FScopeLock scope(&ColorStringsLock);
+		for (int32 i = 0; i < colors.Num(); i++)
+		{
+			colorKey key(colors[i], alpha, exponent);
+			if (const FString* c = ColorStrings.Find(key))
+				strings[i] = *c;
+			else if (const int32* j = pending.Find(key))
+				repeats.Emplace(i, *j);
+			else
+			{
+				pending.Add(key, in.Num());
+				missing.Add(i);
+				in.Add(colors[i]);
+			}
+		}
+	}
+
+	if (!missing.Num())
+		return;
+
+	TArray<FLinearColor> out;
+	out.SetNumUninitialized(in.Num());
+	convertColors(in.GetData(), out.GetData(), in.Num(), exponent);
+
+	{
+		FScopeLock scope(&ColorStringsLock);
+		for (int32 j = 0; j < missing.Num(); j++)
+		{
+			int32 i = missing[j];
+			strings[i] = formatColorString(out[j], alpha);
+			ColorStrings.Add(colorKey(colors[i], alpha, exponent), strings[i]);
+		}
+	}
+
+	for (const TPair<int32, int32>& r : repeats)
+		strings[r.Key] = strings[missing[r.Value]];
+}
+
 FString DocUtils::createVariableName(FString name)
 {
 	std::string g(TCHAR_TO_UTF8(*name));
@@ -147,10 +398,31 @@ FString DocUtils::createVariableName(FString name)
 
 FString DocUtils::getClassName(UClass* _class)
 {
-	FString className = _class->GetPrefixCPP() + _class->GetFName().ToString();
+	FString className = getClassPrefix(_class, _class->HasAnyClassFlags(CLASS_Deprecated)) + _class->GetFName().ToString();
 	return className;
 }
 
+/**
+ * @brief The prefix UClass::GetPrefixCPP() gives a class.
+ * @param _class The class, or any loaded ancestor that decides whether it is an actor
+ * @param isDeprecated Whether the class itself is deprecated
+ * @return A, U, ADEPRECATED_ or UDEPRECATED_.
+ *
+ * Split out so a class that isn't loaded (eg: from asset registry tags) gets
+ * the same prefix as when it is.
+ */
+
+FString DocUtils::getClassPrefix(UClass* _class, bool isDeprecated)
+{
+	bool isActor = _class && _class->IsChildOf(AActor::StaticClass());
+
+	FString prefix = isActor ? "A" : "U";
+	if (isDeprecated)
+		prefix += "DEPRECATED_";
+
+	return prefix;
+}
+
 void DocUtils::addAllGraphs(TArray<UEdGraph*>& container, TArray<UEdGraph*>& graphs)
 {
 	for (UEdGraph* g : graphs)
@@ -178,45 +450,74 @@ FString DocUtils::getTrimmedConfigFilePath(FString path)
 	return trimmed;
 }
 
-FString DocUtils::prepTemplateString(FString prefix, vmap style, FString string)
+/**
+ * @brief Fill a one-off template string.
+ * @param prefix Prepended to every line
+ * @param style The values for each slot
+ * @param string The template
+ * @return The filled and indented string.
+ *
+ * Templates used more than once should be compiled once, and filled
+ * with renderTemplate().
+ */
+
+FString DocUtils::prepTemplateString(FString prefix, styleSlots const& style, FString string)
 {
-	FString h = prefix + string;
+	return renderTemplate(prefix, compiledTemplate(string), style);
+}
 
-	for (auto& e : style)
-		h = h.Replace(*e.Key, *e.Value);
+/**
+ * @brief Fill a compiled template.
+ * @param prefix Prepended to every line
+ * @param t The template
+ * @param style The values for each slot, eg: reporter::NodeStyle
+ * @return The filled and indented string.
+ */
+
+FString DocUtils::renderTemplate(FString prefix, compiledTemplate const& t, styleSlots const& style)
+{
+	FString h = prefix;
+	t.render(h, style, /*emptyCR =*/prefix.IsEmpty());
 
-	//do it twice, in case a value also has variables in it.
-	for (auto& e : style)
-		h = h.Replace(*e.Key, *e.Value);
+	return indentTemplateString(prefix, h);
+}
+
+/**
+ * @brief Indent each line of a rendered template.
+ * @param prefix Prepended to every line
+ * @param h The rendered template
+ * @return The indented string.
+ *
+ * Each '\\r' becomes the prefix, and each '\\n' is followed by the prefix
+ * twice.  Empty elements are already dropped by compiledTemplate::render().
+ */
+
+FString DocUtils::indentTemplateString(FString prefix, FString h)
+{
+	int32 lines = 0;
+	for (TCHAR c : h)
+		lines += (c == '\n' || c == '\r') ? 1 : 0;
 
-	int i = 2;
-	while (i--)		//do it a few times to get all of them
+	if (lines == 0)
+		return h;
+
+	FString out;
+	out.Reserve(h.Len() + lines * prefix.Len() * 2);
+	for (TCHAR c : h)
 	{
-		//clean up any empty <i> tags from replacement
-		h = h.Replace(TEXT("<br/>&nbsp;&nbsp;&nbsp;&nbsp;<i></i>"), TEXT(""));	//for nodes missing a second line
-		h = h.Replace(TEXT("<br/>&nbsp;<i></i>"), TEXT(""));							//for nodes missing a second line
-		h = h.Replace(TEXT("<br/><i></i>"), TEXT(""));									//for nodes missing a second line
-		h = h.Replace(TEXT("<b></b>"), TEXT(""));
-
-		h = h.Replace(TEXT("\r"), *(TEXT("") + prefix));
-		h = h.Replace(TEXT("\n"), *(TEXT("\n") + prefix));
-		//h = h.Replace(TEXT("\\"), *(TEXT("\\\\") + prefix));
-
-			//replace empty font tag
-		FRegexPattern emptyFont(TEXT("<font [^<]*><\\/font>"));
-		FRegexMatcher matcher(emptyFont, h);
-		TArray<FString> m;
-		while (matcher.FindNext())
+		if (c == '\r')
+			out += prefix;
+		else if (c == '\n')
 		{
-			FString s = matcher.GetCaptureGroup(0);
-			//wcout << "MATCH: [" << *s << "]" << endl;
-			m.Add(s);
+			out += c;
+			out += prefix;
+			out += prefix;
 		}
-		for (FString s : m)
-			h = h.Replace(*s, TEXT(""));
+		else
+			out += c;
 	}
 
-	return h;
+	return out;
 }
 
 NodeType DocUtils::getNodeType(UEdGraphNode* node, NodeType defaultType)
@@ -565,6 +866,31 @@ _PORTROWS_
 	return t;
 }
 
+/**
+ * @brief getNodeTemplate(), compiled.
+ * @param type The node type
+ * @param hasDelegate Whether the node shows a delegate pin in its header
+ * @return The compiled template, which lives for the rest of the run.
+ *
+ * Every template is compiled together on the first call, and never changes
+ * after that, so rendering may call this from any thread.
+ */
+
+compiledTemplate const& DocUtils::getCompiledNodeTemplate(NodeType type, bool hasDelegate)
+{
+	static const TArray<compiledTemplate> templates = []()
+	{
+		TArray<compiledTemplate> t;
+		t.SetNum((int32)NodeType::MAX * 2);
+		for (int32 i = 0; i < t.Num(); i++)
+			t[i].compile(getNodeTemplate((NodeType)(i >> 1), (i & 1) != 0));
+		return t;
+	}();
+
+	int32 key = ((int32)type << 1) | (hasDelegate ? 1 : 0);
+	return templates[key];
+}
+
 FString DocUtils::getNodeTooltip(UEdGraphNode* node)
 {
 	FString tooltip = node->GetTooltipText().ToString();
@@ -586,8 +912,11 @@ FString DocUtils::getNodeTooltip(UEdGraphNode* node)
 
 FString DocUtils::getNodeIcon(UEdGraphNode* node)
 {
-	NodeType type = getNodeType(node);
+	return getNodeIcon(getNodeType(node));
+}
 
+FString DocUtils::getNodeIcon(NodeType type)
+{
 	switch (type)
 	{
 		case NodeType::event:
@@ -800,8 +1129,16 @@ bool DocUtils::pinShouldBeVisible(UEdGraphPin* InPin, TMap<FString, FString> vis
 FString DocUtils::getPinPort(UEdGraphPin* p)
 {
 	UEdGraphNode* n = p->GetOwningNode();
-	bool isRoute = getNodeType(n, NodeType::node) == NodeType::route;
+	return getPinPort(p, getNodeType(n, NodeType::node) == NodeType::route);
+}
+
+/**
+ * @brief The port of a pin, when its node's type is already known.
+ * @param isRoute The owning node is a route (reroute) node
+ */
 
+FString DocUtils::getPinPort(UEdGraphPin* p, bool isRoute)
+{
 	if (isRoute)			return "port";
 	if (isDelegatePin(p))	return "delegate";
 
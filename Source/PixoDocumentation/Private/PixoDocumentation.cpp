@@ -4,6 +4,17 @@
 #include "reporter.h"
 #include "blueprintReporter.h"
 #include "materialReporter.h"
+#include "reportManifest.h"
+#include "docServer.h"
+#include "tarArchive.h"
+#include "galleryAtlas.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "PackageTools.h"
+#include "Misc/FileHelper.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
 
 using namespace DocUtils;
 
@@ -34,6 +45,7 @@ PixoDocumentation::PixoDocumentation(
 , totalBlueprintsIgnored(0)
 , totalMaterialsIgnored(0)
 , totalNumFailedLoads(0)
+, totalNumFailedWrites(0)
 {
 	reporter::IgnoreFolders.Empty();
 	//reporter::IgnoreFolders.AddUnique("/Engine");
@@ -46,6 +58,8 @@ PixoDocumentation::PixoDocumentation(
 		reporter::IncludeFolders.AddUnique(i);
 	}
 
+	reporter::compileFolders();
+
 	if (outputMode & doxygen)
 		wcout << "Output Directory: " << *outputDir << endl;
 	else
@@ -54,27 +68,74 @@ PixoDocumentation::PixoDocumentation(
 
 PixoDocumentation::~PixoDocumentation()
 {
+	if (reporter::Manifest == manifest)
+		reporter::Manifest = NULL;
+
+	delete manifest;
+	manifest = NULL;
 }
 
 /**
  * @brief PixoDocumentation::report
- * @return The status of reporting.  Will be 0 on success or the number of read errors.
+ * @return The status of reporting.  Will be 0 on success or the number of read and write errors.
  *
  * This will use the variables defined in the constructor.
  */
 
 int32 PixoDocumentation::report()
 {
+	//a server reports many times
+	totalGraphsProcessed = 0;
+	totalBlueprintsIgnored = 0;
+	totalMaterialsIgnored = 0;
+	totalNumFailedLoads = 0;
+	totalNumFailedWrites = 0;
+
+	reporter::PrefetchWindow = prefetch;
+	reporter::IndexOnly = (outputMode & OutputMode::index) != 0;
+	reporter::MemoryBudgetMB = memoryBudget;
+	reporter::PeakMemoryMB = 0;
+	reporter::NumGCPasses = 0;
+	reporter::ReleasedPackages.Empty();
+	reporter::ThumbnailCacheDir = FPaths::ProjectSavedDir() / TEXT("PixoDocumentation/Thumbnails");
+	fileWriter::NumWritten = 0;
+	fileWriter::NumUnchanged = 0;
+
+	if (!discoverAssets())
+		return 1;
+
+	if (!openManifest())
+		return 1;
+
 	blueprintReporter br(outputDir,stylesheet,groups);
 	materialReporter mr(outputDir,stylesheet,groups);
 
+	br.setAssetList(blueprintAssets);
+	mr.setAssetList(materialAssets);
+
 	if (!clearGroups())
 		return 1;
 
+	//with -OutputArchive, every file is an entry in one tar instead
+	tarArchive tar(archive, outputDir);
+	if (!archive.IsEmpty())
+	{
+		if (!tar.open())
+			return 1;
+
+		fileWriter::Archive = &tar;
+	}
+
+	//files are written in the background while the next asset is emitted
+	fileWriter writer;
+	reporter::Writer = &writer;
+
 	if (outputMode & doxygen)
 	{
+		reporter::Manifest = manifest;
 		br.report(totalGraphsProcessed,totalBlueprintsIgnored,totalNumFailedLoads);
 		mr.report(totalGraphsProcessed,totalMaterialsIgnored,totalNumFailedLoads);
+		reporter::Manifest = NULL;
 	}
 
 	if (outputMode & verbose ||
@@ -82,12 +143,556 @@ int32 PixoDocumentation::report()
 	{
 		reporter r("verbose",outputDir,stylesheet,groups);
 
-		r.report(totalGraphsProcessed,totalBlueprintsIgnored,totalNumFailedLoads);
+		TArray<FAssetData> allAssets(blueprintAssets);
+		allAssets.Append(materialAssets);
+		r.setAssetList(allAssets);
+
+		//only one mode counts graphs; the doxygen reporters already have
+		int verboseGraphs = 0;
+		int& graphCount = (outputMode & doxygen) ? verboseGraphs : totalGraphsProcessed;
+
+		r.report(graphCount,totalBlueprintsIgnored,totalNumFailedLoads);
+	}
+
+	writer.flush();
+	reporter::Writer = NULL;
+	totalNumFailedWrites = writer.getNumFailed();
+
+	//the packages of files that failed in the background are emitted again next run
+	if (manifest)
+	{
+		for (FString const& fpath : writer.getFailedPaths())
+			manifest->invalidateFile(fpath);
+	}
+
+	if (!writeGroups())
+		totalNumFailedLoads++;
+
+	if (manifest && !manifest->save())
+		totalNumFailedLoads++;
+
+	if (fileWriter::Archive)
+	{
+		fileWriter::Archive = NULL;
+		if (!tar.close())
+			totalNumFailedWrites++;
+
+		UE_LOG(LOG_DOT, Display, TEXT("Archived %d file(s) in '%s'."), tar.getNumEntries(), *archive);
 	}
 
 	reportResults();
 
-	return totalNumFailedLoads;
+	return totalNumFailedLoads + totalNumFailedWrites;
+}
+
+/**
+ * @brief PixoDocumentation::merge
+ * @param shards The number of shards that were run with `-Shard=i/N`.
+ * @return 0 on success, or 1 if a shard is missing or unreadable, or a file could not be written.
+ *
+ * Combines the group state saved by each shard into one groups file.  The
+ * per-asset output of each shard is already disjoint, so the groups (and
+ * their galleries) are the only thing that needs merging.
+ */
+
+int32 PixoDocumentation::merge(int32 shards)
+{
+	reporter::GroupList.Empty();
+
+	if (outputDir == "-" || shards <= 0)
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Merging shards needs an -OutputDir and a shard count."));
+		return 1;
+	}
+
+	for (int32 i = 0; i < shards; i++)
+	{
+		FString fpath = getShardStatePath(i, shards);
+
+		FString json;
+		if (!FFileHelper::LoadFileToString(json, *fpath) || !readShardState(json))
+		{
+			UE_LOG(LOG_DOT, Error, TEXT("Could not read shard state '%s'."), *fpath);
+			return 1;
+		}
+	}
+
+	//the merged result is a normal, unsharded groups file
+	shard = 0;
+	numShards = 0;
+	outputMode |= OutputMode::doxygen;
+	totalNumFailedWrites = 0;
+
+	return (writeGroups() && totalNumFailedWrites == 0) ? 0 : 1;
+}
+
+/**
+ * @brief Read the manifest from the last run, and remove what has vanished.
+ * @return false if the output directory can't hold a manifest.
+ *
+ * Only doxygen output to a directory is incremental.  The outputs of any
+ * package in the manifest that discovery no longer finds are deleted, and
+ * anything referencing a changed or deleted package is emitted again.
+ */
+
+bool PixoDocumentation::openManifest()
+{
+	delete manifest;
+	manifest = NULL;
+
+	//an archive is written whole every time
+	if (!(outputMode & OutputMode::doxygen) || outputDir == "-" || !archive.IsEmpty())
+		return true;
+
+	FString fpath = outputDir + "/PixoDocumentation.manifest";
+	if (numShards > 1)
+		fpath += FString::Printf(TEXT(".shard-%d-of-%d"), shard, numShards);
+	fpath += ".json";
+	FPaths::MakePlatformFilename(fpath);
+
+	manifest = new reportManifest(fpath, outputDir, stylesheet);
+	manifest->setFull(full);
+	if (!manifest->load())
+	{
+		UE_LOG(LOG_DOT, Warning, TEXT("Ignoring the unreadable manifest, and regenerating everything."));
+		manifest->setFull(true);
+	}
+
+	TArray<FName> changed;
+	manifest->prune(discoveredPackages, changed);
+
+	for (FName p : discoveredPackages)
+	{
+		if (manifest->refresh(p))
+			changed.Add(p);
+	}
+
+	//on a first or full run, everything is emitted anyway
+	if (manifest->isIncremental())
+		invalidateReferencers(changed);
+
+	//requested by a -Serve client
+	for (FName p : forcedPackages)
+		manifest->forceDirty(p);
+
+	return true;
+}
+
+/**
+ * @brief Stay resident, and report again whenever a client asks.
+ * @param address The socket or pipe to listen on.  Empty for the default.
+ * @return 0 when a client asks the server to quit, or 1 if it couldn't listen
+ * or kept failing to accept clients.
+ *
+ * Editor startup, module loading and the first asset registry scan are paid
+ * once.  Each request names the packages that changed; those are rescanned,
+ * reloaded if they are in memory, and emitted again along with anything the
+ * manifest finds out of date (including their referencers).  A request for
+ * "all" rescans every include root instead, so files changed or added
+ * without being named are found too.
+ *
+ * \sa docServer
+ */
+
+int32 PixoDocumentation::serve(FString address)
+{
+	docServer server(address);
+	if (!server.open())
+		return 1;
+
+	UE_LOG(LOG_DOT, Display, TEXT("Serving on '%s'.  Send package names, one per line, then an empty line.  Send 'quit' to stop."), *server.getAddress());
+
+	//nothing from the first report needs to stay in memory either, or it would be reported stale
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	int32 acceptFailures = 0;
+	while (true)
+	{
+		TArray<FString> lines;
+		if (!server.accept(lines))
+		{
+			//a broken socket or pipe fails every time, so back off and give up
+			if (++acceptFailures >= 10)
+			{
+				UE_LOG(LOG_DOT, Error, TEXT("Could not accept a client %d times in a row.  Stopping."), acceptFailures);
+				return 1;
+			}
+
+			FPlatformProcess::Sleep(FMath::Min(0.1f * (1 << acceptFailures), 5.0f));
+			continue;
+		}
+
+		acceptFailures = 0;
+
+		if (lines.Contains(TEXT("quit")))
+		{
+			server.reply("bye");
+			break;
+		}
+
+		TArray<FName> packages;
+		for (const FString& line : lines)
+		{
+			if (!line.IsEmpty() && line != "all")
+				packages.AddUnique(FName(*line));
+		}
+
+		double start = FPlatformTime::Seconds();
+
+		refreshPackages(packages);
+
+		rescan = lines.Contains(TEXT("all"));
+		forcedPackages = TSet<FName>(packages);
+		int32 failed = report();
+		forcedPackages.Empty();
+		rescan = false;
+
+		server.reply(FString::Printf(TEXT("done graphs=%d unchanged=%d written=%d left=%d failed=%d seconds=%.2f"),
+			totalGraphsProcessed,
+			manifest ? manifest->getNumUnchanged() : 0,
+			fileWriter::NumWritten.load(),
+			fileWriter::NumUnchanged.load(),
+			failed,
+			FPlatformTime::Seconds() - start));
+		server.disconnect();
+
+		//nothing from this request needs to stay in memory
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Bring the asset registry and memory up to date with changed packages.
+ * @param packages Long package names that changed on disk
+ *
+ * A commandlet doesn't watch the disk, so the registry is rescanned for
+ * these packages, and any that are already loaded are reloaded.
+ */
+
+void PixoDocumentation::refreshPackages(TArray<FName> const& packages)
+{
+	if (packages.Num() == 0)
+		return;
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(AssetRegistryConstants::ModuleName).Get();
+
+	TArray<FString> files;
+	TArray<UPackage*> loaded;
+	for (FName p : packages)
+	{
+		FString filename = reportManifest::getPackageFilename(p);
+		UPackage* package = FindPackage(nullptr, *p.ToString());
+
+		if (!filename.IsEmpty())
+			files.Add(filename);
+		else if (package)
+			AssetRegistry.PackageDeleted(package);		//gone from disk
+
+		if (package && !filename.IsEmpty())
+			loaded.Add(package);
+	}
+
+	if (files.Num())
+		AssetRegistry.ScanFilesSynchronous(files, /*bForceRescan =*/true);
+
+	if (loaded.Num())
+	{
+		FText error;
+		if (!UPackageTools::ReloadPackages(loaded, error, EReloadPackagesInteractionMode::AssumePositive))
+			UE_LOG(LOG_DOT, Warning, TEXT("Could not reload every package: %s"), *error.ToString());
+	}
+}
+
+/**
+ * @brief Mark the direct referencers of changed packages as dirty.
+ * @param changed Packages that are new, changed, or deleted since the last run
+ *
+ * Links into another blueprint (`\ref Class::Graph`, and the call graph)
+ * are written into the referencing asset's output.  When the referenced
+ * asset changes, those links may be stale, so the referencers are emitted
+ * again.  Only referencers under the include roots are considered.
+ */
+
+void PixoDocumentation::invalidateReferencers(TArray<FName> const& changed)
+{
+	if (!manifest || changed.Num() == 0)
+		return;
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(AssetRegistryConstants::ModuleName).Get();
+
+	TSet<FName> dirty;
+	for (FName p : changed)
+	{
+		TArray<FName> referencers;
+		AssetRegistry.GetReferencers(p, referencers, UE::AssetRegistry::EDependencyCategory::Package);
+
+		for (FName r : referencers)
+		{
+			if (r != p && discoveredPackages.Contains(r))
+				dirty.Add(r);
+		}
+	}
+
+	for (FName r : dirty)
+		manifest->forceDirty(r);
+
+	if (dirty.Num())
+		UE_LOG(LOG_DOT, Display, TEXT("%d changed package(s) are referenced by %d other package(s), which will be emitted again."), changed.Num(), dirty.Num());
+}
+
+/**
+ * @brief Whether an asset belongs to this process's shard.
+ * @param Asset The asset to check
+ * @return true if not sharded, or if the package name hashes to this shard.
+ *
+ * The CRC of the lowercase package name is stable between runs and machines,
+ * so every process agrees on the split without talking to each other.
+ */
+
+bool PixoDocumentation::isInShard(FAssetData const& Asset)
+{
+	if (numShards <= 1)
+		return true;
+
+	uint32 hash = FCrc::StrCrc32(*Asset.PackageName.ToString().ToLower());
+	return (int32)(hash % (uint32)numShards) == shard;
+}
+
+FString PixoDocumentation::getShardStatePath(int32 _shard, int32 _shards)
+{
+	FString fpath = outputDir + "/" + groups + FString::Printf(TEXT(".shard-%d-of-%d.json"), _shard, _shards);
+	FPaths::MakePlatformFilename(fpath);
+	return fpath;
+}
+
+/**
+ * @brief Write reporter::GroupList to the groups file, or to the shard state.
+ * @return false if the file could not be written.
+ */
+
+bool PixoDocumentation::writeGroups()
+{
+	//only in doxygen mode
+	if (!(outputMode & OutputMode::doxygen))
+		return true;
+
+	if (outputDir == "-")
+		return true;
+
+	FString fpath;
+	FString data;
+
+	if (numShards > 1)
+	{
+		fpath = getShardStatePath(shard, numShards);
+		data = writeShardState();
+	}
+	else
+	{
+		fpath = outputDir + "/" + groups;
+		FPaths::MakePlatformFilename(fpath);
+
+		for (const reportGroupData& g : reporter::GroupList)
+		{
+			galleryAtlas atlas(outputDir, g.name);
+			if (galleryAtlasMode && g.gallery.Num())
+			{
+				//the thumbnails are read back from the output, so the writer must be done
+				atlas.build(g.gallery);
+				totalNumFailedWrites += atlas.getNumFailed();
+				data += reporter::formatGroup(g, &atlas) + "\n";
+			}
+			else
+			{
+				//from an earlier -GalleryAtlas run.  An archive leaves the output directory alone.
+				if (archive.IsEmpty())
+					atlas.removeStaleSheets();
+				data += reporter::formatGroup(g) + "\n";
+			}
+		}
+	}
+
+	FString tpath = fpath;
+	tpath.RemoveFromStart(outputDir);
+	tpath = "[OutputDir]" + tpath;
+
+	FTCHARToUTF8 utf8(*data, data.Len());
+	if (!fileWriter::writeFile((const uint8*)utf8.Get(), utf8.Length(), fpath))
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not open '%s' for writing."), *fpath);
+		return false;
+	}
+
+	wcout << " Writing   " << *tpath << endl;
+
+	return true;
+}
+
+/**
+ * @brief Serialize reporter::GroupList for a later merge().
+ * @return The json text.
+ */
+
+FString PixoDocumentation::writeShardState()
+{
+	TArray<TSharedPtr<FJsonValue>> jgroups;
+
+	for (const reportGroupData& g : reporter::GroupList)
+	{
+		TSharedPtr<FJsonObject> jg = MakeShared<FJsonObject>();
+		jg->SetStringField(TEXT("name"), g.name);
+		jg->SetStringField(TEXT("pretty"), g.namePretty);
+		jg->SetStringField(TEXT("brief"), g.brief);
+		jg->SetStringField(TEXT("details"), g.details);
+
+		TArray<TSharedPtr<FJsonValue>> jgallery;
+		for (const FString& e : g.gallery)
+			jgallery.Add(MakeShared<FJsonValueString>(e));
+		jg->SetArrayField(TEXT("gallery"), jgallery);
+
+		jgroups.Add(MakeShared<FJsonValueObject>(jg));
+	}
+
+	TSharedPtr<FJsonObject> root = MakeShared<FJsonObject>();
+	root->SetNumberField(TEXT("shard"), shard);
+	root->SetNumberField(TEXT("shards"), numShards);
+	root->SetArrayField(TEXT("groups"), jgroups);
+
+	FString json;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+	FJsonSerializer::Serialize(root.ToSharedRef(), writer);
+
+	return json;
+}
+
+/**
+ * @brief Merge one shard's saved groups into reporter::GroupList.
+ * @param json The json text from writeShardState()
+ * @return false if the json could not be parsed.
+ */
+
+bool PixoDocumentation::readShardState(FString const& json)
+{
+	TSharedPtr<FJsonObject> root;
+	TSharedRef<TJsonReader<>> reader = TJsonReaderFactory<>::Create(json);
+
+	if (!FJsonSerializer::Deserialize(reader, root) || !root.IsValid())
+		return false;
+
+	const TArray<TSharedPtr<FJsonValue>>* jgroups = NULL;
+	if (!root->TryGetArrayField(TEXT("groups"), jgroups))
+		return false;
+
+	for (const TSharedPtr<FJsonValue>& v : *jgroups)
+	{
+		const TSharedPtr<FJsonObject>& jg = v->AsObject();
+		if (!jg.IsValid())
+			continue;
+
+		FString name = jg->GetStringField(TEXT("name"));
+		reportGroupData* g = reporter::findGroup(name);
+		if (!g)
+		{
+			g = &reporter::GroupList.AddDefaulted_GetRef();
+			g->name = name;
+			g->namePretty = jg->GetStringField(TEXT("pretty"));
+			g->brief = jg->GetStringField(TEXT("brief"));
+			g->details = jg->GetStringField(TEXT("details"));
+		}
+
+		for (const TSharedPtr<FJsonValue>& e : jg->GetArrayField(TEXT("gallery")))
+			g->gallery.AddUnique(e->AsString());
+	}
+
+	return true;
+}
+
+/**
+ * @brief PixoDocumentation::discoverAssets
+ * @return false if there was nothing that could be scanned.
+ *
+ * This is the one asset registry pass for the whole run.  Instead of
+ * `SearchAllAssets()` over the whole project (once per reporter), only the
+ * `-Include` roots are scanned, and a recursive FARFilter pulls the
+ * blueprints and materials out of those paths.  The results are shared
+ * with every reporter through reporter::setAssetList().
+ */
+
+bool PixoDocumentation::discoverAssets()
+{
+	blueprintAssets.Empty();
+	materialAssets.Empty();
+
+	TArray<FString> scanPaths;
+	for (FString i : reporter::IncludeFolders)
+	{
+		//scan up to the first glob segment.  reporter::shouldReportAsset() does the rest.
+		TArray<FString> segments;
+		i.ParseIntoArray(segments, TEXT("/"), true);
+
+		FString path;
+		for (const FString& segment : segments)
+		{
+			if (folderTrie::isGlob(segment))
+				break;
+			path += "/" + segment;
+		}
+
+		if (!path.IsEmpty())
+			scanPaths.AddUnique(path);
+		else
+			UE_LOG(LOG_DOT, Warning, TEXT("Include '%s' has no folder to scan before its first wildcard."), *i);
+	}
+
+	if (scanPaths.Num() == 0)
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("No include paths to scan."));
+		return false;
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(AssetRegistryConstants::ModuleName).Get();
+	AssetRegistry.ScanPathsSynchronous(scanPaths, /*bForceRescan =*/rescan);
+
+	FARFilter filter;
+	filter.bRecursivePaths = true;
+	filter.bRecursiveClasses = true;
+	for (const FString& path : scanPaths)
+		filter.PackagePaths.Add(FName(*path));
+
+	FARFilter blueprintFilter = filter;
+	FARFilter materialFilter = filter;
+#if ENGINE_MAJOR_VERSION >= 5
+	blueprintFilter.ClassPaths.Add(FTopLevelAssetPath(UBlueprint::StaticClass()->GetPathName()));			//BlueprintBaseClassName
+	materialFilter.ClassPaths.Add(FTopLevelAssetPath(UMaterialInterface::StaticClass()->GetPathName()));	//MaterialBaseClassName
+#else
+	blueprintFilter.ClassNames.Add(UBlueprint::StaticClass()->GetFName());			//BlueprintBaseClassName
+	materialFilter.ClassNames.Add(UMaterialInterface::StaticClass()->GetFName());	//MaterialBaseClassName
+#endif
+
+	//these are in-memory queries against the paths scanned above
+	AssetRegistry.GetAssets(blueprintFilter, blueprintAssets);
+	AssetRegistry.GetAssets(materialFilter, materialAssets);
+
+	//every shard tracks every package, so it can follow references across shards
+	discoveredPackages.Empty();
+	for (const FAssetData& a : blueprintAssets)
+		discoveredPackages.Add(a.PackageName);
+	for (const FAssetData& a : materialAssets)
+		discoveredPackages.Add(a.PackageName);
+
+	if (numShards > 1)
+	{
+		blueprintAssets.RemoveAll([this](const FAssetData& a) { return !isInShard(a); });
+		materialAssets.RemoveAll([this](const FAssetData& a) { return !isInShard(a); });
+
+		UE_LOG(LOG_DOT, Display, TEXT("Shard %d of %d."), shard, numShards);
+	}
+
+	UE_LOG(LOG_DOT, Display, TEXT("Found %d blueprint(s) and %d material(s) in %d include path(s)."), blueprintAssets.Num(), materialAssets.Num(), scanPaths.Num());
+
+	return true;
 }
 
 void PixoDocumentation::reportResults()
@@ -99,11 +704,23 @@ void PixoDocumentation::reportResults()
 		"Ignored %d blueprints(s).\n"
 		"Ignored %d materials(s).\n"
 		"Report Completed with %d assets that failed to load.\n"
+		"Skipped %d unchanged asset(s).\n"
+		"Wrote %d file(s), left %d unchanged, and deleted %d stale file(s).\n"
+		"Failed to write %d file(s).\n"
+		"Peak memory %llu MB, with %d garbage collection(s) (budget: %d MB).\n"
 		"======================================================================================\n"),
 		totalGraphsProcessed,
 		totalBlueprintsIgnored,
 		totalMaterialsIgnored,
-		totalNumFailedLoads
+		totalNumFailedLoads,
+		manifest ? manifest->getNumUnchanged() : 0,
+		fileWriter::NumWritten.load(),
+		fileWriter::NumUnchanged.load(),
+		manifest ? manifest->getNumDeleted() : 0,
+		totalNumFailedWrites,
+		FMath::Max(reporter::PeakMemoryMB, (uint64)(FPlatformMemory::GetStats().PeakUsedPhysical / (1024 * 1024))),
+		reporter::NumGCPasses,
+		reporter::MemoryBudgetMB
 	);
 
 	if (outputMode & doxygen)
@@ -143,7 +760,14 @@ bool PixoDocumentation::clearGroups()
 
 	reporter::GroupList.Empty();
 
+	//the groups file is only written into the archive
+	if (!archive.IsEmpty())
+		return true;
+
+	//a shard never touches the shared groups file, only its own state
 	FString fpath = outputDir + "/" + groups;
+	if (numShards > 1)
+		fpath = getShardStatePath(shard, numShards);
 	FPaths::MakePlatformFilename(fpath);
 
 	std::ofstream::openmode mode = std::ofstream::out | std::ofstream::trunc;
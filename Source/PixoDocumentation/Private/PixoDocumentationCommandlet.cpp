@@ -46,17 +46,33 @@ int32 UPixoDocumentationCommandlet::Main(const FString& Params)
 	HelpParamNames = {
 		"OutputMode",
 		"OutputDir",
+		"OutputArchive",
 		"Include",
 		"Stylesheet",
-		"Groups"
+		"Groups",
+		"Prefetch",
+		"MemoryBudgetMB",
+		"Shard",
+		"MergeShards",
+		"Full",
+		"GalleryAtlas",
+		"Serve"
 	};
 
 	HelpParamDescriptions = {
-		"One of: doxygen|verbose|debug.  If not present, execution will halt.",
+		"One of: doxygen|index|verbose|debug.  If not present, execution will halt.  index writes doxygen class headers, groups and thumbnails from the asset registry alone, without loading packages.  Class bodies are left empty: no members, functions or graphs.",
 		"Path to the output directory, which must exist when this is run.  If not provided, '-' will be used, which means stdout.",
+		"Stream every output file into this tar file as it is produced, instead of writing them into the OutputDir.  Entries are named by their path under the OutputDir (or under the archive's own folder, without one).  Every run writes the whole archive, and it can't be combined with -Shard.",
 		"A comma separated list of UFS paths for parsing.  This will be the plugin's module name, eg: \"/PixoDocumentation,/SomeOtherPlugin\"",
 		"The name of a css stylesheet for dot files, which will be embedded into the resulting dot-syntax comments. (default: 'doxygen-pixo.css')",
-		"The name of the groups file, which will contain a gallery of images parsed from the .uasset files. (default: 'groups.dox')"
+		"The name of the groups file, which will contain a gallery of images parsed from the .uasset files. (default: 'groups.dox')",
+		"The number of packages loaded asynchronously ahead of emission.  Use 0 to load one at a time.  Add -asyncloadingthread for full overlap.  UE5 only; always 0 in UE4. (default: 8)",
+		"With a budget, each package is released once its asset is reported, and garbage is collected between assets while resident memory (in MB) is above it.  Use 0 for no limit. (default: 0)",
+		"Report only shard i of N, as \"i/N\" (eg: 0/4).  Assets are split by a stable hash of their package name, so N processes can share one OutputDir.  Group state is saved beside the groups file for -MergeShards.",
+		"After all N shards have finished, merge their group state into the groups file.  Only -OutputDir and -Groups are used in this mode.",
+		"Regenerate every asset.  Without this, assets whose package is unchanged since the last run (see PixoDocumentation.manifest.json in the OutputDir) are skipped.",
+		"Pack each group's gallery thumbnails into a few sprite sheets (gallery-[group]-[n].png), so a gallery page loads a handful of images instead of one per asset.  The per-asset pngs are still written for the class pages.  Also pass it to -MergeShards.",
+		"Stay resident after the first report, and report again when asked over a local socket (Linux/Mac) or named pipe (Windows).  Optionally -Serve=[path or pipe name].  (default: [Project]/Saved/PixoDocumentation.sock or \\\\.\\pipe\\PixoDocumentation)"
 	};
 
 	HelpWebLink = "https://docs.pixovr.com";
@@ -88,8 +104,22 @@ int32 UPixoDocumentationCommandlet::Main(const FString& Params)
 		groups
 	);
 
+	pd.setPrefetch(prefetch);
+	pd.setMemoryBudget(memoryBudget);
+	pd.setShard(shard, numShards);
+	pd.setFull(full);
+	pd.setArchive(outputArchive);
+	pd.setGalleryAtlas(galleryAtlasMode);
+
+	if (mergeShards > 0)
+		return (pd.merge(mergeShards) > 0);
+
 	int32 result = pd.report();
 
+	//a failed first report still fails the run
+	if (serve)
+		return (pd.serve(serveAddress) > 0 || result > 0);
+
 	return (result > 0);
 }
 
@@ -128,6 +158,16 @@ void UPixoDocumentationCommandlet::InitCommandLine(const FString& Params)
 		//printf("output dir: %s\n", TCHAR_TO_UTF8(*outputDir));
 	}
 
+	if (SwitchParams.Contains(TEXT("OutputArchive")))
+	{
+		outputArchive = SwitchParams[TEXT("OutputArchive")];
+		outputArchive.TrimStartAndEndInline();
+
+		//entries are still named under an output directory, which is never written to
+		if (outputDir == "-")
+			outputDir = FPaths::GetPath(outputArchive);
+	}
+
 	if (SwitchParams.Contains(TEXT("Include")))
 	{
 		FString i = *SwitchParams[TEXT("Include")];
@@ -139,7 +179,56 @@ void UPixoDocumentationCommandlet::InitCommandLine(const FString& Params)
 		}
 	}
 
-	if (includes.Num() == 0)
+	if (Switches.Contains(TEXT("Full")))
+		full = true;
+
+	if (Switches.Contains(TEXT("GalleryAtlas")))
+		galleryAtlasMode = true;
+
+	if (Switches.Contains(TEXT("Serve")))
+		serve = true;
+
+	if (SwitchParams.Contains(TEXT("Serve")))
+	{
+		serve = true;
+		serveAddress = SwitchParams[TEXT("Serve")];
+	}
+
+	if (SwitchParams.Contains(TEXT("MergeShards")))
+		mergeShards = FMath::Max(FCString::Atoi(*SwitchParams[TEXT("MergeShards")]), 0);
+
+	if (SwitchParams.Contains(TEXT("Shard")))
+	{
+		FString s = SwitchParams[TEXT("Shard")];
+		FString i, n;
+		if (s.Split(TEXT("/"), &i, &n))
+		{
+			shard = FCString::Atoi(*i);
+			numShards = FCString::Atoi(*n);
+		}
+
+		if (numShards < 1 || shard < 0 || shard >= numShards)
+		{
+			UE_LOG(LOG_DOT, Warning, TEXT("Bad -Shard '%s', expected i/N with 0 <= i < N."), *s);
+			usage = true;
+		}
+	}
+
+	if (!outputArchive.IsEmpty() && (numShards > 1 || mergeShards > 0))
+	{
+		UE_LOG(LOG_DOT, Warning, TEXT("-OutputArchive can't be combined with -Shard or -MergeShards."));
+		usage = true;
+	}
+
+	//the atlas reads the thumbnails back from the OutputDir
+	if (!outputArchive.IsEmpty() && galleryAtlasMode)
+	{
+		UE_LOG(LOG_DOT, Warning, TEXT("-GalleryAtlas can't be combined with -OutputArchive."));
+		usage = true;
+	}
+
+	//merging only reads shard state, so no includes are needed
+	if (includes.Num() == 0 && mergeShards == 0)
 	{
 		UE_LOG(LOG_DOT, Warning, TEXT("No '-Includes' provided.  Exiting."));
 		usage = true;
@@ -151,6 +240,12 @@ void UPixoDocumentationCommandlet::InitCommandLine(const FString& Params)
 	if (SwitchParams.Contains(TEXT("Groups")))
 		groups = *SwitchParams[TEXT("Groups")];
 
+	if (SwitchParams.Contains(TEXT("Prefetch")))
+		prefetch = FMath::Max(FCString::Atoi(*SwitchParams[TEXT("Prefetch")]), 0);
+
+	if (SwitchParams.Contains(TEXT("MemoryBudgetMB")))
+		memoryBudget = FMath::Max(FCString::Atoi(*SwitchParams[TEXT("MemoryBudgetMB")]), 0);
+
 	if (SwitchParams.Contains(TEXT("OutputMode")))
 	{
 		outputMode = OutputMode::none;		//reset
@@ -168,6 +263,11 @@ void UPixoDocumentationCommandlet::InitCommandLine(const FString& Params)
 			outputMode |= OutputMode::doxygen;
 			break;
 
+		case OutputMode::index:
+			outputMode |= OutputMode::doxygen;
+			outputMode |= OutputMode::index;
+			break;
+
 		case OutputMode::verbose:
 			outputMode |= OutputMode::verbose;
 			outputMode |= OutputMode::debug;
@@ -181,7 +281,7 @@ void UPixoDocumentationCommandlet::InitCommandLine(const FString& Params)
 
 		//printf("output mode %x\n", outputMode);
 	}
-	else
+	else if (mergeShards == 0)
 		UE_LOG(LOG_DOT, Error, TEXT("No OutputMode specified."));
 }
 
@@ -3,18 +3,17 @@
 #pragma once
 
 #include "blueprintReporter.h"
+#include "packagePrefetcher.h"
 
 #include "Runtime/Launch/Resources/Version.h"
 
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+#include "Misc/PackageName.h"
+
 blueprintReporter::blueprintReporter(FString _outputDir, FString _stylesheet, FString _groups)
 : reporter("blueprints", _outputDir, _stylesheet, _groups)
 {
-	//BlueprintBaseClassName
-#if ENGINE_MAJOR_VERSION >= 5
-	loadAssetsByPath(FTopLevelAssetPath(UBlueprint::StaticClass()->GetPathName()));
-#else
-	loadAssets(UBlueprint::StaticClass()->GetFName());
-#endif
 }
 
 void blueprintReporter::report(int &graphCount, int &ignoredCount, int &failedCount)
@@ -22,42 +21,83 @@ void blueprintReporter::report(int &graphCount, int &ignoredCount, int &failedCo
 	LOG( "Parsing Blueprints..." );
 	//wcout << "Parsing Blueprints..." << endl;
 
+	TArray<FAssetData> assets;
 	for (FAssetData const& Asset : assetList)
 	{
-		if (shouldReportAsset(Asset))
+		if (!shouldReportAsset(Asset))
+			ignoredCount++;
+		else if (!skipUnchanged(Asset))
+			assets.Add(Asset);
+	}
+
+	//index only: everything comes from the asset registry, and nothing is loaded
+	if (IndexOnly)
+	{
+		for (FAssetData const& Asset : assets)
 		{
+			if (Manifest)
+				Manifest->begin(Asset.PackageName);
+
+			int r = reportBlueprintIndex(Asset);
+
+			//recorded, but left out of date so a full run regenerates it
+			if (r == 0 && Manifest)
+				Manifest->finish(/*upToDate =*/false);
+			else if (Manifest)
+				Manifest->cancel();
+
+			if (r < 0)
+				failedCount++;
+		}
+
+		assets.Empty();
+	}
+
+	//packages load ahead of us, and are handed back as they finish
+	packagePrefetcher prefetcher(assets, PrefetchWindow);
+
+	FAssetData Asset;
+	while (prefetcher.next(Asset))
+	{
 #if ENGINE_MAJOR_VERSION >= 5
-			FString const AssetPath = Asset.GetObjectPathString();// .ObjectPath.ToString();
+		FString const AssetPath = Asset.GetObjectPathString();// .ObjectPath.ToString();
 #else
-			FString const AssetPath = Asset.ObjectPath.ToString();
+		FString const AssetPath = Asset.ObjectPath.ToString();
 #endif
 
-			//FString const AssetName = Asset.AssetName.ToString();
-			//FString const PackagePath = Asset.PackagePath.ToString();
-
-			//Load with LOAD_NoWarn and LOAD_DisableCompileOnLoad.
-			UBlueprint* LoadedBlueprint = Cast<UBlueprint>(StaticLoadObject(Asset.GetClass(), /*Outer =*/nullptr, *AssetPath, nullptr, LOAD_NoWarn | LOAD_DisableCompileOnLoad));
-			if (LoadedBlueprint == nullptr
-				|| !LoadedBlueprint->IsValidLowLevel()
-				|| !LoadedBlueprint->ParentClass->IsValidLowLevel()
-				)
-			{
-				failedCount++;
-				wcerr << "Failed to load: " << *AssetPath << endl;
-				continue;
-			}
-			else
-			{
-				int r = reportBlueprint(_tab, LoadedBlueprint);
+		//FString const AssetName = Asset.AssetName.ToString();
+		//FString const PackagePath = Asset.PackagePath.ToString();
 
-				if (r)
-					graphCount += r;
-				else
-					return;
-			}
+		//Load with LOAD_NoWarn and LOAD_DisableCompileOnLoad.  If prefetched, this just finds the loaded object.
+		UBlueprint* LoadedBlueprint = Cast<UBlueprint>(StaticLoadObject(Asset.GetClass(), /*Outer =*/nullptr, *AssetPath, nullptr, LOAD_NoWarn | LOAD_DisableCompileOnLoad));
+		if (LoadedBlueprint == nullptr
+			|| !LoadedBlueprint->IsValidLowLevel()
+			|| !LoadedBlueprint->ParentClass->IsValidLowLevel()
+			)
+		{
+			failedCount++;
+			wcerr << "Failed to load: " << *AssetPath << endl;
+			continue;
 		}
 		else
-			ignoredCount++;
+		{
+			if (Manifest)
+				Manifest->begin(Asset.PackageName);
+
+			int r = reportBlueprint(_tab, LoadedBlueprint);
+
+			if (r > 0 && Manifest)
+				Manifest->finish();
+			else if (Manifest)
+				Manifest->cancel();
+
+			if (r)
+				graphCount += r;
+			else
+				return;
+		}
+
+		trackMemory(prefetcher, LoadedBlueprint->GetPackage());
 	}
 
 	reportGroup(
@@ -86,23 +126,12 @@ int blueprintReporter::reportBlueprint(FString prefix, UBlueprint* blueprint)
 	//each graph will make calls to nodes and variables.  Clear these before we report each blueprint.
 	GraphCalls.Empty();
 
-	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
 	subDir = package->GetName();				//get the full UDF path
 	subDir = FPaths::GetPath(subDir);			//chop the "file" entry off
 	subDir.RemoveFromStart("/");				//remove prefix slash from UFS path
 	currentDir = outputDir + "/" + subDir;		//jam it all together
 	FPaths::NormalizeDirectoryName(currentDir);	//fix/normalize the slashes
-
-	// Directory Exists?
-	//FPaths::DirectoryExists(dir);
-	if (!platformFile.DirectoryExists(*currentDir))
-	{
-		if (!platformFile.CreateDirectoryTree(*currentDir))
-		{
-			UE_LOG(LOG_DOT, Error, TEXT("Could not create folder: %s"),*currentDir);
-			return -1;
-		}
-	}
+	//the folder is made along with the first file written into it
 
 	path = currentDir + "/" + className + ".h";
 	FPaths::MakePlatformFilename(path);				//clean slashes
@@ -154,17 +183,149 @@ int blueprintReporter::reportBlueprint(FString prefix, UBlueprint* blueprint)
 	return graphs.Num();
 }
 
-void blueprintReporter::reportGraph(FString prefix, UEdGraph* g)
+/**
+ * @brief Report a blueprint's class header from its asset registry tags.
+ * @param Asset The blueprint asset, which is not loaded
+ * @return 0 on success, or -1 on failure.
+ *
+ * The header, group and gallery entry match a full report.  The class body
+ * is left empty, as members and graphs are not in the registry; the .cpp is
+ * rewritten without calls, so no stale call graph is left behind.
+ */
+
+int blueprintReporter::reportBlueprintIndex(FAssetData const& Asset)
 {
-	pinConnections.Empty();		//clear out all connections for each new graph
+	FString packageName = Asset.PackageName.ToString();
+
+	GraphCalls.Empty();
+
+	if (!setCurrentDir(packageName))
+		return -1;
+
+	//the native parent is always loaded, and decides the class prefix
+	FString nativeParentPath = Asset.GetTagValueRef<FString>(FBlueprintTags::NativeParentClassPath);
+	UClass* nativeParent = FindObject<UClass>(nullptr, *FPackageName::ExportTextPathToObjectPath(nativeParentPath));
+
+	blueprintHeaderData header;
+	header.className = getTagClassName(Asset, FBlueprintTags::GeneratedClassPath, nativeParent);
+	header.parentClass = getTagClassName(Asset, FBlueprintTags::ParentClassPath, nativeParent);
+	header.packageName = packageName;
+	header.brief = "A blueprint class.";
+	header.displayName = Asset.GetTagValueRef<FString>(FBlueprintTags::BlueprintDisplayName);
+	header.description = Asset.GetTagValueRef<FString>(FBlueprintTags::BlueprintDescription);
+	header.isDataOnly = Asset.GetTagValueRef<bool>(FBlueprintTags::IsDataOnly);
+	header.isDeprecated = (Asset.GetTagValueRef<uint32>(FBlueprintTags::ClassFlags) & CLASS_Deprecated) != 0;
+
+	if (nativeParent)
+		header.config = getTrimmedConfigFilePath(nativeParent->GetDefaultConfigFilename());
+
+	if (header.className.IsEmpty() || header.parentClass.IsEmpty())
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Missing class tags for '%s'."), *packageName);
+		return -1;
+	}
+
+	if (outputDir != "-")
+	{
+		FString pngName = header.className + ".png";
+		FString pngPath = currentDir + "\\" + pngName;
+		FPaths::MakePlatformFilename(pngPath);
 
-	writeGraphHeader(prefix, g, "Blueprint");
+		FString tpngPath = pngPath;
+		tpngPath.RemoveFromStart(outputDir);
+
+		if (createThumbnailFile(Asset, pngPath))
+		{
+			int width = 256;
+			FString fmt;
+
+			fmt = "\\image{inline} html {0} \"{1}\" width={2}px";
+			header.imageTag = FString::Format(*fmt, { tpngPath, header.className, width });
 
+			fmt = "\\link {1} &thinsp; \\image html {0} \"{1}\" width={2}px \\endlink";
+			FString galleryEntry = FString::Format(*fmt, { tpngPath, header.className, width });
+			addGalleryEntry(galleryEntry);
+		}
+	}
+
+	FString path = currentDir + "/" + header.className + ".h";
+	FPaths::MakePlatformFilename(path);				//clean slashes
+	if (!openFile(path))
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not open '%s' for writing."), *path);
+		return -1;
+	}
+
+	writeBlueprintHeader(header, "blueprints", "Blueprint");
+	writeAssetFooter();
+
+	closeFile();		//close .h file
+
+	path = currentDir + "/" + header.className + ".cpp";
+	FPaths::MakePlatformFilename(path);				//clean slashes
+	if (!openFile(path))
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not open '%s' for writing."), *path);
+		return -1;
+	}
+
+	writeAssetCalls(header.className);
+
+	closeFile();		//close .cpp file
+
+	return 0;
+}
+
+/**
+ * @brief Get a class name (with its A/U prefix) from a class path tag.
+ * @param Asset The blueprint asset
+ * @param tag One of the FBlueprintTags class paths
+ * @param nativeParent The blueprint's native parent, if found
+ * @return The prefixed class name, or empty if the tag is missing.
+ *
+ * Blueprint classes take their prefix from their native parent and their
+ * own deprecation, as UClass::GetPrefixCPP() would once loaded.  A parent
+ * blueprint's class flags are read from its own asset.
+ */
+
+FString blueprintReporter::getTagClassName(FAssetData const& Asset, FName tag, UClass* nativeParent)
+{
+	FString path = FPackageName::ExportTextPathToObjectPath(Asset.GetTagValueRef<FString>(tag));
+	if (path.IsEmpty())
+		return "";
+
+	//native classes are always loaded, and so is any class already in memory
+	UClass* loadedClass = FindObject<UClass>(nullptr, *path);
+	if (loadedClass)
+		return getClassName(loadedClass);
+
+	FAssetData classAsset = Asset;
+	if (tag != FBlueprintTags::GeneratedClassPath)
+	{
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(AssetRegistryConstants::ModuleName).Get();
+
+		TArray<FAssetData> classAssets;
+		AssetRegistry.GetAssetsByPackageName(FName(*FPackageName::ObjectPathToPackageName(path)), classAssets);
+
+		FAssetData* blueprintAsset = classAssets.FindByPredicate([](FAssetData const& a) { return a.FindTag(FBlueprintTags::ClassFlags); });
+		if (blueprintAsset)
+			classAsset = *blueprintAsset;
+	}
+
+	bool isDeprecated = (classAsset.GetTagValueRef<uint32>(FBlueprintTags::ClassFlags) & CLASS_Deprecated) != 0;
+	FString name = FPackageName::ObjectPathToObjectName(path);
+
+	return getClassPrefix(nativeParent, isDeprecated) + name;
+}
+
+void blueprintReporter::reportGraph(FString prefix, UEdGraph* g)
+{
+	//what the nodes tell us about their subgraphs
 	for (UEdGraphNode* n : g->Nodes)
 		reportNode(prefix + _tab, n);
 
-	writeGraphConnections(prefix);
-	writeGraphFooter(prefix, g);
+	extractGraph(g, "Blueprint");
+	renderGraph(prefix, Graph);
 
 	//TODO: local variables for a function (graph)
 	//
@@ -202,8 +363,6 @@ void blueprintReporter::reportNode(FString prefix, UEdGraphNode* n)
 
 		GraphDescriptions.Add(subgraph, brief);
 	}
-
-	writeNodeBody(prefix, n);
 }
 
 void blueprintReporter::writeBlueprintHeader(
@@ -249,31 +408,46 @@ void blueprintReporter::writeBlueprintHeader(
 			fmt = "\\link {1} &thinsp; \\image html {0} \"{1}\" width={2}px \\endlink";
 			//FString galleryEntry = FString::Format(*fmt, { pngName, className, width });
 			FString galleryEntry = FString::Format(*fmt, { tpngPath, className, width });
-			GalleryList.Add(galleryEntry);
+			addGalleryEntry(galleryEntry);
 		}
 	}
 
-	// Gives the line places to break if needed.
-	// TODO: (actually turns out doxygen won't do it, so left this here with
-	// &thinsp; for when I do figure out how to do it with &#8203;)
-	FString packageNameBreaks = packageName.Replace(TEXT("/"), TEXT("&thinsp;/"));
-	//packageName = packageName.Replace(TEXT("/"), TEXT("&zwnj;/"));
-
-	// not sure why they allow you to put a cosmetic name on a blueprintfor.
-	FString displayName = blueprint->BlueprintDisplayName;
-
 	//FName MetaDeprecated = TEXT("DeprecatedNode");
-	bool isDeprecated = blueprint->bDeprecate;
-	FString sDeprecated = "This blueprint will be removed in future versions.";
 	//*object->GetMetaData("DeprecationMessage")
 
+	blueprintHeaderData header;
+	header.className = className;
+	header.parentClass = parentClass;
+	header.packageName = packageName;
+	header.brief = FString::Printf(TEXT("A blueprint class with %d graphs."), graphCount);
+	header.imageTag = imagetag;
+
 	//The (default) config file where public values can be saved/referenced.
-	FString config = getTrimmedConfigFilePath(blueprint->GetDefaultConfigFilename());
+	header.config = getTrimmedConfigFilePath(blueprint->GetDefaultConfigFilename());
+
+	// not sure why they allow you to put a cosmetic name on a blueprintfor.
+	header.displayName = blueprint->BlueprintDisplayName;
+	header.isDataOnly = isDataOnly;
+	header.isDeprecated = blueprint->bDeprecate;
 
-	FString description;
 	//description += "	This class " + blueprint->GetDesc() + ".\n";
 	//description += "\n";
-	description += blueprint->BlueprintDescription;
+	header.description = blueprint->BlueprintDescription;
+
+	writeBlueprintHeader(header, group, qualifier);
+}
+
+void blueprintReporter::writeBlueprintHeader(blueprintHeaderData const& header, FString group, FString qualifier)
+{
+	// Gives the line places to break if needed.
+	// TODO: (actually turns out doxygen won't do it, so left this here with
+	// &thinsp; for when I do figure out how to do it with &#8203;)
+	FString packageNameBreaks = header.packageName.Replace(TEXT("/"), TEXT("&thinsp;/"));
+	//packageName = packageName.Replace(TEXT("/"), TEXT("&zwnj;/"));
+
+	FString sDeprecated = "This blueprint will be removed in future versions.";
+
+	FString description = header.description;
 	description = description.TrimStartAndEnd();
 	description = description.Replace(TEXT("\n"), TEXT("\n	"));
 
@@ -284,22 +458,22 @@ void blueprintReporter::writeBlueprintHeader(
 		*out << "	\\qualifier " << *qualifier << endl;
 	*out << "	\\ingroup " << *group << endl;
 
-	if (isDeprecated)
+	if (header.isDeprecated)
 		*out << "	\\deprecated " << *sDeprecated << endl;
 
 	//*out << "	\\brief UDF Path: <b>" << *packageName << "</b> "<< endl;
-	*out << "	\\brief A blueprint class with " << graphCount << " graphs." << endl;
+	*out << "	\\brief " << *header.brief << endl;
 	*out << endl;
 
-	if (!imagetag.IsEmpty())					//floats right... needs to be as early in the description as possible.
-		*out << "	" << *imagetag << endl;
+	if (!header.imageTag.IsEmpty())					//floats right... needs to be as early in the description as possible.
+		*out << "	" << *header.imageTag << endl;
 
 	*out << "	UDF Path: <b>" << *packageNameBreaks << "</b>" << endl;
-	*out << "	<br/>Config: <b>" << *config << "</b>" << endl;
+	*out << "	<br/>Config: <b>" << *header.config << "</b>" << endl;
 
-	if (!displayName.IsEmpty())
-		*out << "	<br/>Display Name: <b>" << *displayName << "</b>" << endl;
-	if (isDataOnly)
+	if (!header.displayName.IsEmpty())
+		*out << "	<br/>Display Name: <b>" << *header.displayName << "</b>" << endl;
+	if (header.isDataOnly)
 		*out << "	<br/>This blueprint is <b>Data Only</b>" << endl;
 	if (!description.IsEmpty())
 	{	*out << "	" << endl;
@@ -308,9 +482,9 @@ void blueprintReporter::writeBlueprintHeader(
 
 	//*out << "	<div style='clear:both;'/>" << endl;	//now a css thing elsewhere
 
-	*out << "	\\headerfile " << *className << ".h \"" << *packageName << "\"" << endl;
+	*out << "	\\headerfile " << *header.className << ".h \"" << *header.packageName << "\"" << endl;
 	*out << "*/" << endl;
-	*out << "class " << *className << " : public " << *parentClass << endl;
+	*out << "class " << *header.className << " : public " << *header.parentClass << endl;
 	*out << "{" << endl;
 }
 
@@ -0,0 +1,362 @@
+// (c) 2023 PixoVR
+
+#include "compiledTemplate.h"
+
+//the conditional elements: opening, closing, and what nests inside
+struct conditionalElement
+{
+	const TCHAR*	open;
+	const TCHAR*	close;
+	const TCHAR*	nest;
+	bool		hasAttributes;
+};
+
+static const conditionalElement ConditionalElements[] = {
+	{ TEXT("<font "),						TEXT("</font>"),	TEXT("<font "),	true	},
+	{ TEXT("<b>"),							TEXT("</b>"),		TEXT("<b>"),	false	},
+	{ TEXT("<br/>&nbsp;&nbsp;&nbsp;&nbsp;<i>"),	TEXT("</i>"),		TEXT("<i>"),	false	},	//for nodes missing a second line
+	{ TEXT("<br/>&nbsp;<i>"),				TEXT("</i>"),		TEXT("<i>"),	false	},
+	{ TEXT("<br/><i>"),						TEXT("</i>"),		TEXT("<i>"),	false	}
+};
+
+compiledTemplate::compiledTemplate()
+{
+}
+
+compiledTemplate::compiledTemplate(FString source)
+{
+	compile(source);
+}
+
+compiledTemplate::~compiledTemplate()
+{
+}
+
+/**
+ * @brief Split a template into literal, slot and conditional element tokens.
+ * @param source The template, eg: from DocUtils::getNodeTemplate()
+ */
+
+void compiledTemplate::compile(FString source)
+{
+	text = source;
+	tokens.Empty();
+
+	compileRange(0, text.Len(), true);
+}
+
+/**
+ * @brief Append the template, with its slots filled, to a buffer.
+ * @param out The buffer to append to
+ * @param style The values for each slot, eg: reporter::NodeStyle, or the pin data for a row
+ * @param emptyCR Whether a '\\r' will be indented to nothing (ie: there is no prefix)
+ *
+ * Conditional elements are rendered, and then rolled back if their content
+ * came out empty, as it will be once indented.
+ */
+
+void compiledTemplate::render(FString& out, styleSlots const& style, bool emptyCR) const
+{
+	out.Reserve(out.Len() + text.Len() * 2);
+
+	TArray<int32, TInlineAllocator<8>> marks;
+
+	const TCHAR* begin = *text;
+	for (int32 i = 0; i < tokens.Num(); i++)
+	{
+		const token& t = tokens[i];
+		switch (t.type)
+		{
+		case literal:
+			out.AppendChars(begin + t.start, t.len);
+			break;
+
+		case slot:
+		{
+			const FString* value = style.find(t.key);
+			if (value)
+				appendExpanded(out, *value, style);
+			else
+				out.AppendChars(begin + t.start, t.len);
+			break;
+		}
+
+		case elementBegin:
+		case contentBegin:
+			marks.Push(out.Len());
+			break;
+
+		case contentEnd:
+		{
+			int32 content = marks.Pop();
+			if (isBlank(out, content, emptyCR) && !(t.hasAttributes && hasTag(out, marks.Last() + 1, content)))
+			{
+				out.LeftInline(marks.Pop());
+				i = t.skip;
+			}
+			break;
+		}
+
+		case elementEnd:
+			marks.Pop();
+			break;
+		}
+	}
+}
+
+void compiledTemplate::compileRange(int32 from, int32 to, bool elements)
+{
+	const TCHAR* begin = *text;
+	int32 lit = from;
+	int32 p = from;
+	while (p < to)
+	{
+		int32 contentFrom, contentTo, elementTo;
+		bool hasAttributes;
+		if (elements && findElement(p, to, contentFrom, contentTo, elementTo, &hasAttributes) && isConditional(contentFrom, contentTo))
+		{
+			addLiteral(lit, p);
+
+			addToken(elementBegin);
+			compileRange(p, contentFrom, false);		//the opening tag may have slots in its attributes
+			addToken(contentBegin);
+			compileRange(contentFrom, contentTo, true);
+			int32 end = addToken(contentEnd);
+			tokens[end].hasAttributes = hasAttributes;
+			addLiteral(contentTo, elementTo);
+			tokens[end].skip = addToken(elementEnd);
+
+			p = elementTo;
+			lit = p;
+			continue;
+		}
+
+		int32 len;
+		StyleKey key = findSlot(begin + p, begin + to, len);
+		if (key == StyleKey::MAX)
+		{
+			p++;
+			continue;
+		}
+
+		addLiteral(lit, p);
+
+		int32 s = addToken(slot);
+		tokens[s].start = p;
+		tokens[s].len = len;
+		tokens[s].key = key;
+
+		p += len;
+		lit = p;
+	}
+
+	addLiteral(lit, to);
+}
+
+void compiledTemplate::addLiteral(int32 from, int32 to)
+{
+	if (to <= from)
+		return;
+
+	int32 l = addToken(literal);
+	tokens[l].start = from;
+	tokens[l].len = to - from;
+}
+
+int32 compiledTemplate::addToken(tokenType type)
+{
+	int32 t = tokens.AddDefaulted();
+	tokens[t].type = type;
+	return t;
+}
+
+/**
+ * @brief Whether a conditional element starts at p.
+ * @param p Where to look
+ * @param to The end of the range
+ * @param contentFrom Receives the start of the element's content
+ * @param contentTo Receives the end of its content (the closing tag)
+ * @param elementTo Receives the end of the closing tag
+ * @param hasAttributes Receives whether the opening tag has attributes.  May be NULL.
+ * @return true if there is an element with a matching closing tag.
+ */
+
+bool compiledTemplate::findElement(int32 p, int32 to, int32& contentFrom, int32& contentTo, int32& elementTo, bool* hasAttributes) const
+{
+	if (text[p] != '<')
+		return false;
+
+	for (const conditionalElement& e : ConditionalElements)
+	{
+		if (!startsWith(p, to, e.open))
+			continue;
+
+		int32 c = p + FCString::Strlen(e.open);
+		if (e.hasAttributes)
+		{
+			//attributes, without any nested tags
+			while (c < to && text[c] != '>' && text[c] != '<')
+				c++;
+			if (c >= to || text[c] != '>')
+				return false;
+			c++;
+		}
+		contentFrom = c;
+		if (hasAttributes)
+			*hasAttributes = e.hasAttributes;
+
+		int32 depth = 0;
+		int32 closeLen = FCString::Strlen(e.close);
+		for (; c < to; c++)
+		{
+			if (startsWith(c, to, e.nest))
+				depth++;
+			else if (startsWith(c, to, e.close))
+			{
+				if (depth == 0)
+				{
+					contentTo = c;
+					elementTo = c + closeLen;
+					return true;
+				}
+				depth--;
+			}
+		}
+
+		return false;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Whether a range is only slots and conditional elements, and so may render empty.
+ */
+
+bool compiledTemplate::isConditional(int32 from, int32 to) const
+{
+	const TCHAR* begin = *text;
+	int32 p = from;
+	while (p < to)
+	{
+		int32 contentFrom, contentTo, elementTo;
+		if (findElement(p, to, contentFrom, contentTo, elementTo) && isConditional(contentFrom, contentTo))
+		{
+			p = elementTo;
+			continue;
+		}
+
+		int32 len;
+		if (findSlot(begin + p, begin + to, len) == StyleKey::MAX)
+			return false;		//literal text, which is never empty
+
+		p += len;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Whether a tag starts anywhere in out[from, to).
+ *
+ * An opening tag whose attributes picked up a tag from a value is not an
+ * empty element, and is kept.
+ */
+
+bool compiledTemplate::hasTag(FString const& out, int32 from, int32 to)
+{
+	for (int32 c = from; c < to; c++)
+	{
+		if (out[c] == '<')
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Whether out[from, end) is empty, once indented.
+ */
+
+bool compiledTemplate::isBlank(FString const& out, int32 from, bool emptyCR)
+{
+	if (out.Len() == from)
+		return true;
+
+	if (!emptyCR)
+		return false;
+
+	for (int32 c = from; c < out.Len(); c++)
+	{
+		if (out[c] != '\r')
+			return false;
+	}
+
+	return true;
+}
+
+bool compiledTemplate::startsWith(int32 p, int32 to, const TCHAR* s) const
+{
+	int32 len = FCString::Strlen(s);
+	return p + len <= to && FCString::Strncmp(*text + p, s, len) == 0;
+}
+
+/**
+ * @brief The length of the slot at p, if there is one.
+ * @return The length, including both underscores, or 0.
+ */
+
+int32 compiledTemplate::slotLength(const TCHAR* p, const TCHAR* end)
+{
+	if (*p != '_')
+		return 0;
+
+	const TCHAR* s = p + 1;
+	while (s < end && ((*s >= 'A' && *s <= 'Z') || (*s >= '0' && *s <= '9')))
+		s++;
+
+	if (s == p + 1 || s >= end || *s != '_')
+		return 0;
+
+	return (int32)(s - p) + 1;
+}
+
+StyleKey compiledTemplate::findSlot(const TCHAR* p, const TCHAR* end, int32& len)
+{
+	len = slotLength(p, end);
+	return len ? styleSlots::findKey(FString(len, p)) : StyleKey::MAX;
+}
+
+void compiledTemplate::appendExpanded(FString& out, FString const& value, styleSlots const& style)
+{
+	//most values are plain text
+	int32 u;
+	if (!value.FindChar('_', u))
+	{
+		out += value;
+		return;
+	}
+
+	const TCHAR* p = *value;
+	const TCHAR* end = p + value.Len();
+	const TCHAR* lit = p;
+	while (p < end)
+	{
+		int32 len;
+		StyleKey key = findSlot(p, end, len);
+		const FString* v = key == StyleKey::MAX ? NULL : style.find(key);
+		if (!v)
+		{
+			p++;
+			continue;
+		}
+
+		out.AppendChars(lit, (int32)(p - lit));
+		out += *v;
+
+		p += len;
+		lit = p;
+	}
+
+	out.AppendChars(lit, (int32)(end - lit));
+}
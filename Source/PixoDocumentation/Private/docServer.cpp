@@ -0,0 +1,244 @@
+// (c) 2023 PixoVR
+
+#include "docServer.h"
+
+#include "reporter.h"
+
+#if !PLATFORM_WINDOWS
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+/**
+ * @brief docServer::docServer
+ * @param _address The socket file (Linux/Mac) or pipe name (Windows).  Empty for the default.
+ */
+
+docServer::docServer(FString _address)
+: address(_address.IsEmpty() ? getDefaultAddress() : _address)
+{
+}
+
+docServer::~docServer()
+{
+	close();
+}
+
+FString docServer::getDefaultAddress()
+{
+#if PLATFORM_WINDOWS
+	return TEXT("\\\\.\\pipe\\PixoDocumentation");
+#else
+	FString path = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("PixoDocumentation.sock"));
+	return path;
+#endif
+}
+
+#if !PLATFORM_WINDOWS
+/**
+ * @brief Remove the socket file at a path.
+ * @param path The socket path
+ * @return false if something other than a socket is there.  It is left alone.
+ */
+
+static bool removeSocket(const char* path)
+{
+	struct stat st;
+	if (lstat(path, &st) != 0)
+		return true;				//nothing there
+	if (!S_ISSOCK(st.st_mode))
+		return false;
+	unlink(path);
+	return true;
+}
+#endif
+
+/**
+ * @brief Start listening.
+ * @return false if the socket or pipe could not be created.
+ */
+
+bool docServer::open()
+{
+	close();
+
+#if PLATFORM_WINDOWS
+	created = pipe.Create(address, /*bAsServer =*/true, /*bAsync =*/false);
+	if (!created)
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not create pipe '%s'."), *address);
+		return false;
+	}
+#else
+	FTCHARToUTF8 path(*address);
+
+	sockaddr_un addr;
+	FMemory::Memzero(addr);
+	addr.sun_family = AF_UNIX;
+	if (path.Length() >= (int32)sizeof(addr.sun_path))
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Socket path is too long: '%s'."), *address);
+		return false;
+	}
+	FMemory::Memcpy(addr.sun_path, path.Get(), path.Length());
+
+	//left behind by a server that didn't exit cleanly
+	if (!removeSocket(addr.sun_path))
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("'%s' exists and is not a socket."), *address);
+		return false;
+	}
+
+	listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd < 0)
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not create socket (errno %d)."), errno);
+		return false;
+	}
+
+	if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 4) != 0)
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not listen on '%s' (errno %d)."), *address, errno);
+		close();
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+void docServer::close()
+{
+	disconnect();
+
+#if PLATFORM_WINDOWS
+	if (created)
+		pipe.Destroy();
+	created = false;
+#else
+	if (listenFd >= 0)
+	{
+		::close(listenFd);
+		removeSocket(TCHAR_TO_UTF8(*address));
+	}
+	listenFd = -1;
+#endif
+}
+
+/**
+ * @brief Wait for a client, and read its request.
+ * @param lines Receives the request lines, trimmed, without the terminating empty line.
+ * @return false if no client could be accepted.
+ */
+
+bool docServer::accept(TArray<FString>& lines)
+{
+	lines.Empty();
+
+#if PLATFORM_WINDOWS
+	if (!created && !open())
+		return false;
+
+	if (!pipe.OpenConnection())
+	{
+		UE_LOG(LOG_DOT, Warning, TEXT("Could not connect a client on '%s'."), *address);
+		close();
+		return false;
+	}
+#else
+	clientFd = ::accept(listenFd, NULL, NULL);
+	if (clientFd < 0)
+	{
+		UE_LOG(LOG_DOT, Warning, TEXT("Could not accept a client (errno %d)."), errno);
+		return false;
+	}
+
+#ifdef SO_NOSIGPIPE
+	int on = 1;
+	setsockopt(clientFd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+#endif
+
+	TArray<ANSICHAR> line;
+	ANSICHAR c;
+	while (readByte(c))
+	{
+		if (c == '\r')
+			continue;
+
+		if (c != '\n')
+		{
+			line.Add(c);
+			continue;
+		}
+
+		if (line.Num() == 0)
+			break;			//end of request
+
+		line.Add('\0');
+		lines.Add(FString(UTF8_TO_TCHAR(line.GetData())).TrimStartAndEnd());
+		line.Reset();
+	}
+
+	if (line.Num())
+	{
+		line.Add('\0');
+		lines.Add(FString(UTF8_TO_TCHAR(line.GetData())).TrimStartAndEnd());
+	}
+
+	return true;
+}
+
+bool docServer::reply(FString line)
+{
+	FTCHARToUTF8 data(*(line + "\n"));
+
+#if PLATFORM_WINDOWS
+	return pipe.WriteBytes(data.Length(), data.Get());
+#else
+	const ANSICHAR* p = data.Get();
+	int32 left = data.Length();
+	while (left > 0)
+	{
+		//a client that hung up must not SIGPIPE the editor
+#ifdef MSG_NOSIGNAL
+		ssize_t n = send(clientFd, p, left, MSG_NOSIGNAL);
+#else
+		ssize_t n = write(clientFd, p, left);
+#endif
+		if (n <= 0)
+			return false;
+		p += n;
+		left -= n;
+	}
+	return true;
+#endif
+}
+
+void docServer::disconnect()
+{
+#if PLATFORM_WINDOWS
+	//a synchronous pipe serves one client, so make a new one for the next
+	if (created)
+	{
+		pipe.Destroy();
+		created = false;
+	}
+#else
+	if (clientFd >= 0)
+		::close(clientFd);
+	clientFd = -1;
+#endif
+}
+
+bool docServer::readByte(ANSICHAR& c)
+{
+#if PLATFORM_WINDOWS
+	return pipe.ReadBytes(1, &c);
+#else
+	return read(clientFd, &c, 1) == 1;
+#endif
+}
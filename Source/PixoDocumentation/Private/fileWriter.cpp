@@ -0,0 +1,171 @@
+// (c) 2023 PixoVR
+
+#include "fileWriter.h"
+
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+#include "Misc/ScopeLock.h"
+
+#include "reporter.h"
+#include "tarArchive.h"
+
+std::atomic<int32> fileWriter::NumWritten(0);
+std::atomic<int32> fileWriter::NumUnchanged(0);
+tarArchive* fileWriter::Archive = NULL;
+
+/**
+ * @brief fileWriter::fileWriter
+ * @param _window The number of writes allowed in flight.
+ */
+
+fileWriter::fileWriter(int32 _window)
+: window(FMath::Max(_window, 1))
+, numFailed(0)
+{
+}
+
+fileWriter::~fileWriter()
+{
+	//nothing is left half written behind us
+	flush();
+}
+
+/**
+ * @brief Queue a file to be written.
+ * @param data The whole file
+ * @param fpath Where to write it
+ * @param append Add to the end of the file, instead of replacing it
+ */
+
+void fileWriter::write(TArray<uint8> data, FString fpath, bool append)
+{
+	queue(fpath, [data = MoveTemp(data), fpath, append]()
+	{
+		return writeFile(data.GetData(), data.Num(), fpath, append);
+	});
+}
+
+/**
+ * @brief Queue some work that ends in writing a file, eg: encoding a png.
+ * @param fpath The file the work writes
+ * @param work The work, which may run on any thread.  Returns false on failure.
+ */
+
+void fileWriter::queue(FString fpath, TUniqueFunction<bool()> work)
+{
+	if (!GThreadPool || !FPlatformProcess::SupportsMultithreading())
+	{
+		if (!work())
+			fail(fpath);
+		return;
+	}
+
+	int32 same = inflight.IndexOfByPredicate([&fpath](const job& j) { return j.path == fpath; });
+	if (same != INDEX_NONE)
+		wait(same);
+
+	if (inflight.Num() >= window)
+		wait(0);
+
+	job& j = inflight.AddDefaulted_GetRef();
+	j.path = fpath;
+	j.done = Async(EAsyncExecution::ThreadPool, [this, fpath, work = MoveTemp(work)]()
+	{
+		if (!work())
+			fail(fpath);
+	});
+}
+
+/**
+ * @brief Wait for every queued write.
+ */
+
+void fileWriter::flush()
+{
+	while (inflight.Num())
+		wait(0);
+}
+
+void fileWriter::wait(int32 index)
+{
+	inflight[index].done.Wait();
+	inflight.RemoveAt(index);
+}
+
+/**
+ * @brief The files whose write (or the work before it) failed.
+ * @return The paths, as they were queued.
+ *
+ * Only complete after flush().
+ */
+
+TArray<FString> fileWriter::getFailedPaths()
+{
+	FScopeLock lock(&failedLock);
+	return failedPaths;
+}
+
+void fileWriter::fail(FString const& fpath)
+{
+	FScopeLock lock(&failedLock);
+	failedPaths.Add(fpath);
+	numFailed++;
+}
+
+/**
+ * @brief Write a file, unless it already holds exactly these bytes.
+ * @param data The new contents
+ * @param size ..and their size
+ * @param fpath The file
+ * @param append Add to the end of the file instead, which is always written
+ * @return false if the file could not be written.
+ *
+ * Most files come out the same as last time, so the size is checked first,
+ * and only a file of the same size is read back and compared.  Missing
+ * folders are created.  Safe to call from any thread.
+ *
+ * With an Archive, the file is added to it instead.
+ */
+
+bool fileWriter::writeFile(const uint8* data, int64 size, FString const& fpath, bool append)
+{
+	if (Archive)
+	{
+		if (Archive->add(fpath, data, size))
+		{
+			NumWritten++;
+			return true;
+		}
+
+		UE_LOG(LOG_DOT, Error, TEXT("Could not add '%s' to the archive."), *fpath);
+		return false;
+	}
+
+	IFileManager& FileManager = IFileManager::Get();
+
+	if (!append && FileManager.FileSize(*fpath) == size)
+	{
+		TArray64<uint8> existing;
+		if (FFileHelper::LoadFileToArray(existing, *fpath, FILEREAD_Silent) && existing.Num() == size && FMemory::Memcmp(existing.GetData(), data, size) == 0)
+		{
+			NumUnchanged++;
+			return true;
+		}
+	}
+
+	//the writer makes any folders it needs
+	TUniquePtr<FArchive> Ar(FileManager.CreateFileWriter(*fpath, append ? FILEWRITE_Append : FILEWRITE_None));
+	if (Ar)
+	{
+		Ar->Serialize(const_cast<uint8*>(data), size);
+		if (Ar->Close())
+		{
+			NumWritten++;
+			return true;
+		}
+	}
+
+	UE_LOG(LOG_DOT, Error, TEXT("Could not write '%s'."), *fpath);
+	return false;
+}
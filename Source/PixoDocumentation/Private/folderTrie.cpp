@@ -0,0 +1,207 @@
+// (c) 2023 PixoVR
+
+#include "folderTrie.h"
+
+static inline bool isSeparator(TCHAR c)
+{
+	return c == '/' || c == '.' || c == ':';
+}
+
+folderTrie::folderTrie()
+{
+	reset();
+}
+
+folderTrie::~folderTrie()
+{
+}
+
+void folderTrie::reset()
+{
+	nodes.Empty();
+	nodes.AddDefaulted();		//root
+}
+
+/**
+ * @brief Add a folder to the trie.
+ * @param folder A package path, optionally with glob segments.  eg: "/Plugin/Folder"
+ * @param ignore true for IgnoreFolders, false for IncludeFolders
+ */
+
+void folderTrie::add(FString folder, bool ignore)
+{
+	int32 n = 0;
+
+	const TCHAR* p = *folder;
+	const TCHAR* end = p + folder.Len();
+	while (p < end)
+	{
+		while (p < end && isSeparator(*p))
+			p++;
+
+		const TCHAR* s = p;
+		while (p < end && !isSeparator(*p))
+			p++;
+
+		if (p > s)
+			n = addChild(n, FStringView(s, (int32)(p - s)));
+	}
+
+	nodes[n].flags |= ignore ? matchFlags::ignore : matchFlags::include;
+}
+
+int32 folderTrie::addChild(int32 parent, FStringView segment)
+{
+	//careful: adding a node can move nodes[parent]
+	if (segment.Equals(TEXT("**")))
+	{
+		if (nodes[parent].anyDepth == INDEX_NONE)
+		{
+			int32 child = nodes.AddDefaulted();
+			nodes[child].isAnyDepth = true;
+			nodes[parent].anyDepth = child;
+		}
+
+		return nodes[parent].anyDepth;
+	}
+
+	if (isGlob(segment))
+	{
+		FString pattern(segment);
+
+		for (const TPair<FString, int32>& g : nodes[parent].globs)
+		{
+			if (g.Key.Equals(pattern, ESearchCase::IgnoreCase))
+				return g.Value;
+		}
+
+		int32 child = nodes.AddDefaulted();
+		nodes[parent].globs.Add(TPair<FString, int32>(pattern, child));
+		return child;
+	}
+
+	FName name(segment.Len(), segment.GetData());
+
+	const int32* existing = nodes[parent].children.Find(name);
+	if (existing)
+		return *existing;
+
+	int32 child = nodes.AddDefaulted();
+	nodes[parent].children.Add(name, child);
+	return child;
+}
+
+bool folderTrie::isGlob(FStringView segment)
+{
+	int32 i;
+	return segment.FindChar('*', i) || segment.FindChar('?', i);
+}
+
+/**
+ * @brief Check a path against the trie.
+ * @param path An object or package path.  eg: "/Plugin/Folder/BP.BP_C"
+ * @return true if an include folder matches, and no ignore folder does.
+ */
+
+bool folderTrie::matches(FStringView path) const
+{
+	uint8 found = matchFlags::none;
+
+	stateList states;
+	activate(0, states, found);
+
+	const TCHAR* p = path.GetData();
+	const TCHAR* end = p + path.Len();
+	while (p < end && states.Num() && !(found & matchFlags::ignore))
+	{
+		while (p < end && isSeparator(*p))
+			p++;
+
+		const TCHAR* s = p;
+		while (p < end && !isSeparator(*p))
+			p++;
+
+		if (p == s)
+			break;
+
+		//a segment that isn't already a name can't match a literal folder
+		FName name((int32)(p - s), s, FNAME_Find);
+
+		stateList next;
+		for (int32 n : states)
+		{
+			const node& current = nodes[n];
+
+			if (current.isAnyDepth)
+				activate(n, next, found);
+
+			if (!name.IsNone())
+			{
+				const int32* child = current.children.Find(name);
+				if (child)
+					activate(*child, next, found);
+			}
+
+			for (const TPair<FString, int32>& g : current.globs)
+			{
+				if (globMatch(*g.Key, *g.Key + g.Key.Len(), s, p))
+					activate(g.Value, next, found);
+			}
+		}
+
+		states = next;
+	}
+
+	return (found & matchFlags::include) && !(found & matchFlags::ignore);
+}
+
+void folderTrie::activate(int32 n, stateList& states, uint8& found) const
+{
+	if (states.Contains(n))
+		return;
+
+	states.Add(n);
+	found |= nodes[n].flags;
+
+	//"**" can match no segments at all
+	if (nodes[n].anyDepth != INDEX_NONE)
+		activate(nodes[n].anyDepth, states, found);
+}
+
+/**
+ * @brief Case-insensitive glob match of one segment.
+ *
+ * '*' matches any run of characters and '?' matches one.
+ */
+
+bool folderTrie::globMatch(const TCHAR* pattern, const TCHAR* patternEnd, const TCHAR* text, const TCHAR* textEnd)
+{
+	const TCHAR* star = NULL;		//just past the last '*' seen
+	const TCHAR* starText = NULL;		//where that '*' started matching
+
+	while (text < textEnd)
+	{
+		if (pattern < patternEnd && (*pattern == '?' || FChar::ToLower(*pattern) == FChar::ToLower(*text)))
+		{
+			pattern++;
+			text++;
+		}
+		else if (pattern < patternEnd && *pattern == '*')
+		{
+			star = ++pattern;
+			starText = text;
+		}
+		else if (star)
+		{
+			pattern = star;
+			text = ++starText;
+		}
+		else
+			return false;
+	}
+
+	while (pattern < patternEnd && *pattern == '*')
+		pattern++;
+
+	return pattern == patternEnd;
+}
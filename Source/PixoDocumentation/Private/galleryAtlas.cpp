@@ -0,0 +1,310 @@
+// (c) 2023 PixoVR
+
+#include "galleryAtlas.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+
+#include "reporter.h"
+
+/**
+ * @brief galleryAtlas::galleryAtlas
+ * @param _outputDir The output directory, which gallery png paths are relative to
+ * @param _groupName The group, which names the sheets
+ */
+
+galleryAtlas::galleryAtlas(FString _outputDir, FString _groupName)
+: outputDir(_outputDir)
+{
+	for (TCHAR c : _groupName.ToLower())
+		name.AppendChar(FChar::IsAlnum(c) ? c : '-');
+}
+
+galleryAtlas::~galleryAtlas()
+{
+}
+
+/**
+ * @brief Pack the gallery's thumbnails into sheets, and write them.
+ * @param entries The group's gallery entries
+ * @return The number of sheets written.
+ *
+ * Sheets left over from a larger gallery last time are deleted.  A sheet
+ * that can't be written is counted in getNumFailed(), and its entries are
+ * kept as they were.
+ */
+
+int32 galleryAtlas::build(TArray<FString> const& entries)
+{
+	imageWrapper = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+
+	TArray<FString> list = entries;
+	list.Sort();		//the same order as the gallery
+
+	sprites.Empty();
+	numSheets = 0;
+	numFailed = 0;
+
+	TArray<uint8> sheet;
+	int32 cell = 0;			//in the current sheet
+	int32 rows = 0;
+
+	for (const FString& e : list)
+	{
+		sprite& s = sprites.AddDefaulted_GetRef();
+		s.entry = e;
+
+		FString pngPath;
+		TArray<uint8> bgra;
+		int32 w, h;
+		if (!parseEntry(e, s.className, pngPath) || !loadImage(pngPath, bgra, w, h))
+			continue;
+
+		if (cell == 0)
+			sheet.SetNumZeroed(Columns * CellSize * Rows * CellSize * 4);
+
+		//fit the cell, keeping the aspect
+		float scale = FMath::Min((float)CellSize / w, (float)CellSize / h);
+		s.sheet = numSheets;
+		s.x = (cell % Columns) * CellSize;
+		s.y = (cell / Columns) * CellSize;
+		s.w = FMath::Clamp(FMath::RoundToInt(w * scale), 1, CellSize);
+		s.h = FMath::Clamp(FMath::RoundToInt(h * scale), 1, CellSize);
+
+		blit(bgra, w, h, sheet, Columns * CellSize, s.x, s.y, s.w, s.h);
+
+		rows = cell / Columns + 1;
+		if (++cell == Columns * Rows)
+		{
+			finishSheet(sheet, rows);
+			cell = 0;
+		}
+	}
+
+	if (cell)
+	{
+		sheet.SetNum(Columns * CellSize * rows * CellSize * 4);		//only the rows used
+		finishSheet(sheet, rows);
+	}
+
+	removeStaleSheets();
+
+	return numSheets;
+}
+
+/**
+ * @brief Delete this group's sheets from an earlier run that weren't written this time.
+ *
+ * With no sheets built (eg: without `-GalleryAtlas`), every sheet is stale.
+ */
+
+void galleryAtlas::removeStaleSheets() const
+{
+	FString prefix = FString::Printf(TEXT("gallery-%s-"), *name);
+
+	TArray<FString> files;
+	IFileManager::Get().FindFiles(files, *(outputDir / prefix + "*.png"), /*Files =*/true, /*Directories =*/false);
+
+	for (const FString& f : files)
+	{
+		//another group's name may start with ours
+		FString index = f.Mid(prefix.Len()).LeftChop(4);
+		if (index.IsEmpty() || !index.IsNumeric() || FCString::Atoi(*index) < numSheets)
+			continue;
+
+		FString fpath = outputDir / f;
+		FPaths::MakePlatformFilename(fpath);
+
+		UE_LOG(LOG_DOT, Display, TEXT(" Deleting  [OutputDir]/%s"), *f);
+		IFileManager::Get().Delete(*fpath);
+	}
+}
+
+/**
+ * @brief Write the sheet being packed, or put its sprites back to plain entries if it can't be.
+ * @param sheet The sheet's pixels
+ * @param rows The rows of cells used
+ */
+
+void galleryAtlas::finishSheet(TArray<uint8> const& sheet, int32 rows)
+{
+	if (writeSheet(numSheets, sheet, Columns * CellSize, rows * CellSize))
+	{
+		numSheets++;
+		return;
+	}
+
+	//nothing may refer to a sheet that wasn't written.  The next sheet takes its place.
+	for (sprite& s : sprites)
+	{
+		if (s.sheet == numSheets)
+			s.sheet = INDEX_NONE;
+	}
+
+	numFailed++;
+}
+
+/**
+ * @brief The gallery items, with their sprites and the css that places them.
+ * @return The items, ready to go inside the gallery's div.
+ */
+
+FString galleryAtlas::formatItems() const
+{
+	FString items;
+
+	//so doxygen copies the sheets next to the pages
+	for (int32 i = 0; i < numSheets; i++)
+		items += "	<div style='display:none'>\\image html " + getSheetName(i) + "</div>\n";
+
+	if (numSheets)
+	{
+		items += "	\\htmlonly<style>\n";
+		items += "	.gallery .sprite { display:inline-block; background-repeat:no-repeat; vertical-align:bottom; }\n";
+
+		for (int32 i = 0; i < numSheets; i++)
+			items += FString::Printf(TEXT("	.gallery .%s { background-image:url('%s'); }\n"), *getSheetClass(i), *getSheetName(i));
+
+		for (int32 i = 0; i < sprites.Num(); i++)
+		{
+			const sprite& s = sprites[i];
+			if (s.sheet == INDEX_NONE)
+				continue;
+
+			items += FString::Printf(TEXT("	.gallery .%s { background-position:-%dpx -%dpx; width:%dpx; height:%dpx; }\n"),
+				*getSpriteClass(i), s.x, s.y, s.w, s.h);
+		}
+
+		items += "	</style>\\endhtmlonly\n";
+	}
+
+	for (int32 i = 0; i < sprites.Num(); i++)
+	{
+		const sprite& s = sprites[i];
+		if (s.sheet == INDEX_NONE)
+		{
+			items += "	" + s.entry + "\n";
+			continue;
+		}
+
+		// \link ABP_ActorTest_C &thinsp; <span class='sprite sheet-blueprints-0 sprite-blueprints-12' title='ABP_ActorTest_C'></span> \endlink
+		items += FString::Printf(TEXT("	\\link %s &thinsp; <span class='sprite %s %s' title='%s'></span> \\endlink\n"),
+			*s.className, *getSheetClass(s.sheet), *getSpriteClass(i), *s.className);
+	}
+
+	return items;
+}
+
+/**
+ * @brief Pick the class name and png out of a gallery entry.
+ *
+ * Entries are written by the reporters as:
+ * `\link [class] &thinsp; \image html [png] "[class]" width=256px \endlink`
+ */
+
+bool galleryAtlas::parseEntry(FString const& entry, FString& className, FString& pngPath) const
+{
+	static const FString link = "\\link ";
+	static const FString image = "\\image html ";
+
+	int32 l = entry.Find(link);
+	int32 i = entry.Find(image);
+	if (l == INDEX_NONE || i == INDEX_NONE)
+		return false;
+
+	l += link.Len();
+	int32 le = entry.Find(" ", ESearchCase::CaseSensitive, ESearchDir::FromStart, l);
+	i += image.Len();
+	int32 ie = entry.Find(" ", ESearchCase::CaseSensitive, ESearchDir::FromStart, i);
+	if (le == INDEX_NONE || ie == INDEX_NONE)
+		return false;
+
+	className = entry.Mid(l, le - l);
+	pngPath = outputDir + entry.Mid(i, ie - i);
+	FPaths::MakePlatformFilename(pngPath);
+
+	return true;
+}
+
+bool galleryAtlas::loadImage(FString const& pngPath, TArray<uint8>& bgra, int32& w, int32& h) const
+{
+	TArray<uint8> png;
+	if (!FFileHelper::LoadFileToArray(png, *pngPath, FILEREAD_Silent))
+	{
+		UE_LOG(LOG_DOT, Warning, TEXT("Gallery atlas: could not read '%s'."), *pngPath);
+		return false;
+	}
+
+	TSharedPtr<IImageWrapper> ImageWrapper = imageWrapper->CreateImageWrapper(EImageFormat::PNG);
+	if (!ImageWrapper.IsValid() || !ImageWrapper->SetCompressed(png.GetData(), png.Num()) || !ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, bgra))
+	{
+		UE_LOG(LOG_DOT, Warning, TEXT("Gallery atlas: could not decode '%s'."), *pngPath);
+		return false;
+	}
+
+	w = (int32)ImageWrapper->GetWidth();
+	h = (int32)ImageWrapper->GetHeight();
+
+	return w > 0 && h > 0;
+}
+
+bool galleryAtlas::writeSheet(int32 index, TArray<uint8> const& bgra, int32 w, int32 h) const
+{
+	FString fpath = outputDir + "/" + getSheetName(index);
+	FPaths::MakePlatformFilename(fpath);
+
+	TSharedPtr<IImageWrapper> ImageWrapper = imageWrapper->CreateImageWrapper(EImageFormat::PNG);
+	if (!ImageWrapper.IsValid() || !ImageWrapper->SetRaw(bgra.GetData(), bgra.Num(), w, h, ERGBFormat::BGRA, 8))
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not encode gallery atlas '%s'."), *fpath);
+		return false;
+	}
+
+	const TArray64<uint8>& png = ImageWrapper->GetCompressed();
+	if (png.Num() == 0 || !fileWriter::writeFile(png.GetData(), png.Num(), fpath))
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not write gallery atlas '%s'."), *fpath);
+		return false;
+	}
+
+	FString tpath = fpath;
+	tpath.RemoveFromStart(outputDir);
+	tpath = "[OutputDir]" + tpath;
+
+	wcout << " Writing   " << *tpath << endl;
+
+	return true;
+}
+
+FString galleryAtlas::getSheetName(int32 index) const
+{
+	return FString::Printf(TEXT("gallery-%s-%d.png"), *name, index);
+}
+
+FString galleryAtlas::getSheetClass(int32 index) const
+{
+	return FString::Printf(TEXT("sheet-%s-%d"), *name, index);
+}
+
+FString galleryAtlas::getSpriteClass(int32 index) const
+{
+	return FString::Printf(TEXT("sprite-%s-%d"), *name, index);
+}
+
+/**
+ * @brief Nearest neighbour scale of one BGRA image into another.
+ */
+
+void galleryAtlas::blit(TArray<uint8> const& src, int32 sw, int32 sh, TArray<uint8>& dst, int32 dstride, int32 dx, int32 dy, int32 dw, int32 dh)
+{
+	for (int32 y = 0; y < dh; y++)
+	{
+		const uint8* srow = src.GetData() + (int64)(y * sh / dh) * sw * 4;
+		uint8* drow = dst.GetData() + ((int64)(dy + y) * dstride + dx) * 4;
+
+		for (int32 x = 0; x < dw; x++)
+			FMemory::Memcpy(drow + x * 4, srow + (x * sw / dw) * 4, 4);
+	}
+}
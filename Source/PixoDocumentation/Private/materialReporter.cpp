@@ -3,6 +3,7 @@
 #pragma once
 
 #include "materialReporter.h"
+#include "packagePrefetcher.h"
 
 #include "Runtime/Launch/Resources/Version.h"
 
@@ -23,12 +24,6 @@
 materialReporter::materialReporter(FString _outputDir, FString _stylesheet, FString _groups)
 : reporter("materials", _outputDir, _stylesheet, _groups)
 {
-	//MaterialBaseClassName
-#if ENGINE_MAJOR_VERSION >= 5
-	loadAssetsByPath(FTopLevelAssetPath(UMaterialInterface::StaticClass()->GetPathName()));
-#else
-	loadAssets(UMaterialInterface::StaticClass()->GetFName());
-#endif
 }
 
 void materialReporter::report(int &graphCount, int &ignoredCount, int &failedCount)
@@ -36,42 +31,83 @@ void materialReporter::report(int &graphCount, int &ignoredCount, int &failedCou
 	LOG( "Parsing Materials..." );
 	//wcout << "Parsing Materials..." << endl;
 
+	TArray<FAssetData> assets;
 	for (FAssetData const& Asset : assetList)
 	{
-		if (shouldReportAsset(Asset))
+		if (!shouldReportAsset(Asset))
+			ignoredCount++;
+		else if (!skipUnchanged(Asset))
+			assets.Add(Asset);
+	}
+
+	//index only: everything comes from the asset registry, and nothing is loaded
+	if (IndexOnly)
+	{
+		for (FAssetData const& Asset : assets)
 		{
+			if (Manifest)
+				Manifest->begin(Asset.PackageName);
+
+			int r = reportMaterialIndex(Asset);
+
+			//recorded, but left out of date so a full run regenerates it
+			if (r == 0 && Manifest)
+				Manifest->finish(/*upToDate =*/false);
+			else if (Manifest)
+				Manifest->cancel();
+
+			if (r < 0)
+				failedCount++;
+		}
+
+		assets.Empty();
+	}
+
+	//packages load ahead of us, and are handed back as they finish
+	packagePrefetcher prefetcher(assets, PrefetchWindow);
+
+	FAssetData Asset;
+	while (prefetcher.next(Asset))
+	{
 #if ENGINE_MAJOR_VERSION >= 5
-			FString const AssetPath = Asset.GetObjectPathString(); // .ObjectPath.ToString();
+		FString const AssetPath = Asset.GetObjectPathString(); // .ObjectPath.ToString();
 #else
-			FString const AssetPath = Asset.ObjectPath.ToString();
+		FString const AssetPath = Asset.ObjectPath.ToString();
 #endif
-			//FString const AssetName = Asset.AssetName.ToString();
-			//FString const PackagePath = Asset.PackagePath.ToString();
-
-			//Load with LOAD_NoWarn and LOAD_DisableCompileOnLoad.
-			UMaterialInterface * LoadedMaterial = Cast<UMaterialInterface>(StaticLoadObject(Asset.GetClass(), /*Outer =*/nullptr, *AssetPath, nullptr, LOAD_NoWarn | LOAD_DisableCompileOnLoad));
-			//UMaterialInterface* LoadedMaterial = Cast<UMaterialInterface>(StaticLoadObject(Asset.GetClass(), /*Outer =*/nullptr, *AssetPath, nullptr, LOAD_None));
-			if (LoadedMaterial == nullptr
-				|| !LoadedMaterial->IsValidLowLevel()
-				|| !LoadedMaterial->GetClass()->IsValidLowLevel()
-				)
-			{
-				failedCount++;
-				wcerr << "Failed to load: " << *AssetPath << endl;
-				continue;
-			}
-			else
-			{
-				int r = reportMaterial(_tab, LoadedMaterial);
-
-				if (r)
-					graphCount += r;
-				else
-					return;
-			}
+		//FString const AssetName = Asset.AssetName.ToString();
+		//FString const PackagePath = Asset.PackagePath.ToString();
+
+		//Load with LOAD_NoWarn and LOAD_DisableCompileOnLoad.  If prefetched, this just finds the loaded object.
+		UMaterialInterface * LoadedMaterial = Cast<UMaterialInterface>(StaticLoadObject(Asset.GetClass(), /*Outer =*/nullptr, *AssetPath, nullptr, LOAD_NoWarn | LOAD_DisableCompileOnLoad));
+		//UMaterialInterface* LoadedMaterial = Cast<UMaterialInterface>(StaticLoadObject(Asset.GetClass(), /*Outer =*/nullptr, *AssetPath, nullptr, LOAD_None));
+		if (LoadedMaterial == nullptr
+			|| !LoadedMaterial->IsValidLowLevel()
+			|| !LoadedMaterial->GetClass()->IsValidLowLevel()
+			)
+		{
+			failedCount++;
+			wcerr << "Failed to load: " << *AssetPath << endl;
+			continue;
 		}
 		else
-			ignoredCount++;
+		{
+			if (Manifest)
+				Manifest->begin(Asset.PackageName);
+
+			int r = reportMaterial(_tab, LoadedMaterial);
+
+			if (r > 0 && Manifest)
+				Manifest->finish();
+			else if (Manifest)
+				Manifest->cancel();
+
+			if (r)
+				graphCount += r;
+			else
+				return;
+		}
+
+		trackMemory(prefetcher, LoadedMaterial->GetPackage());
 	}
 
 	reportGroup(
@@ -99,23 +135,12 @@ int materialReporter::reportMaterial(FString prefix, UMaterialInterface* materia
 	//each graph will make calls to nodes and variables.  Clear these before we report each blueprint.
 	GraphCalls.Empty();
 
-	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
 	subDir = package->GetName();				//get the full UDF path
 	subDir = FPaths::GetPath(subDir);			//chop the "file" entry off
 	subDir.RemoveFromStart("/");				//remove prefix slash from UFS path
 	currentDir = outputDir + "/" + subDir;		//jam it all together
 	FPaths::NormalizeDirectoryName(currentDir);	//fix/normalize the slashes
-
-	// Directory Exists?
-	//FPaths::DirectoryExists(dir);
-	if (!platformFile.DirectoryExists(*currentDir))
-	{
-		if (!platformFile.CreateDirectoryTree(*currentDir))
-		{
-			UE_LOG(LOG_DOT, Error, TEXT("Could not create folder: %s"), *currentDir);
-			return -1;
-		}
-	}
+	//the folder is made along with the first file written into it
 
 	path = currentDir + "/" + className + ".h";
 	FPaths::MakePlatformFilename(path);				//clean slashes
@@ -152,13 +177,14 @@ int materialReporter::reportMaterial(FString prefix, UMaterialInterface* materia
 		fmt = "\\link {1} &thinsp; \\image html {0} \"{1}\" width={2}px \\endlink";
 		//FString galleryEntry = FString::Format(*fmt, { pngName, className, width });
 		FString galleryEntry = FString::Format(*fmt, { tpngPath, className, width });
-		GalleryList.Add(galleryEntry);
+		addGalleryEntry(galleryEntry);
 	}
 
 	TArray<UEdGraph*> graphs;
 
 	//UEdGraph* graph = material->MaterialGraph;
 	UMaterialGraph* graph = material->MaterialGraph;
+	bool createdGraph = !graph;
 	if (!graph)
 	{
 		//graph = material->MaterialGraph = CastChecked<UMaterialGraph>(FBlueprintEditorUtils::CreateNewGraph(material, NAME_None, UMaterialGraph::StaticClass(), UMaterialGraphSchema::StaticClass()));
@@ -211,22 +237,119 @@ int materialReporter::reportMaterial(FString prefix, UMaterialInterface* materia
 
 	closeFile();		//close .cpp file
 
+	//when memory is bounded, don't keep the graph we built attached to the material
+	if (createdGraph && MemoryBudgetMB > 0)
+		material->MaterialGraph = NULL;
+
 	currentMaterialInterface = NULL;
 
 	return graphs.Num();
 }
 
-void materialReporter::reportGraph(FString prefix, UEdGraph* g)
+/**
+ * @brief Report a material's class header from the asset registry.
+ * @param Asset The material asset, which is not loaded
+ * @return 0 on success, or -1 on failure.
+ *
+ * Only what the registry knows is written: the class, the package, the
+ * config, the domain of a material and the thumbnail.  The description and
+ * graphs need a full report.  The header itself is shared with a full report.
+ */
+
+int materialReporter::reportMaterialIndex(FAssetData const& Asset)
 {
-	pinConnections.Empty();		//clear out all connections for each new graph
+	FString packageName = Asset.PackageName.ToString();
+	FString className = Asset.AssetName.ToString();
+	FString imageTag = "";
+
+	GraphCalls.Empty();
+
+	if (!setCurrentDir(packageName))
+		return -1;
+
+	UClass* assetClass = Asset.GetClass();			//native, so never loaded here
+	if (!assetClass)
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Unknown class for '%s'."), *packageName);
+		return -1;
+	}
+
+	if (outputDir != "-")
+	{
+		FString pngName = className + ".png";
+		FString pngPath = currentDir + "\\" + pngName;
+		FPaths::MakePlatformFilename(pngPath);
+
+		FString tpngPath = pngPath;
+		tpngPath.RemoveFromStart(outputDir);
+
+		if (createThumbnailFile(Asset, pngPath))
+		{
+			int width = 256;
+			FString fmt;
+
+			fmt = "\\image{inline} html {0} \"{1}\" width={2}px";
+			imageTag = FString::Format(*fmt, { tpngPath, className, width });
 
-	writeGraphHeader(prefix, g, "Material");
+			fmt = "\\link {1} &thinsp; \\image html {0} \"{1}\" width={2}px \\endlink";
+			FString galleryEntry = FString::Format(*fmt, { tpngPath, className, width });
+			addGalleryEntry(galleryEntry);
+		}
+	}
+
+	FString path = currentDir + "/" + className + ".h";
+	FPaths::MakePlatformFilename(path);				//clean slashes
+	if (!openFile(path))
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not open '%s' for writing."), *path);
+		return -1;
+	}
+
+	materialHeaderData header;
+	header.className = className;
+	header.parentClass = getClassName(UMaterial::StaticClass());	//as a loaded material reports it
+	header.packageName = packageName;
+	header.brief = "A material.";
+	header.imageTag = imageTag;
+	header.config = getTrimmedConfigFilePath(GetDefault<UMaterial>()->GetDefaultConfigFilename());
+
+	//only materials have a domain, and it is searchable
+	FString domain;
+	if (Asset.GetTagValue(GET_MEMBER_NAME_CHECKED(UMaterial, MaterialDomain), domain))
+	{
+		domain.RemoveFromStart("MD_");
+		header.domain = domain;
+	}
 
+	writeMaterialHeader(header, "materials", "Material");
+
+	writeAssetFooter();
+
+	closeFile();		//close .h file
+
+	path = currentDir + "/" + className + ".cpp";
+	FPaths::MakePlatformFilename(path);				//clean slashes
+	if (!openFile(path))
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not open '%s' for writing."), *path);
+		return -1;
+	}
+
+	writeAssetCalls(className);
+
+	closeFile();		//close .cpp file
+
+	return 0;
+}
+
+void materialReporter::reportGraph(FString prefix, UEdGraph* g)
+{
+	//what the nodes tell us about their subgraphs
 	for (UEdGraphNode* n : g->Nodes)
 		reportNode(prefix + _tab, n);
 
-	writeGraphConnections(prefix);
-	writeGraphFooter(prefix, g);
+	extractGraph(g, "Material");
+	renderGraph(prefix, Graph);
 
 	//TODO: local variables for a function (graph)
 	//
@@ -283,8 +406,6 @@ void materialReporter::reportNode(FString prefix, UEdGraphNode* n)
 		GraphDescriptions.Add(subgraph, brief);
 	}
 #endif
-
-	writeNodeBody(prefix, n);
 }
 
 FString materialReporter::getGraphCPP(UEdGraph* graph, FString _namespace)
@@ -414,22 +535,21 @@ void materialReporter::writeMaterialHeader(
 	//FMaterialInheritanceChain chain;
 	//material->GetMaterialInheritanceChain(chain);
 
-	// Gives the line places to break if needed.
-	// TODO: (actually turns out doxygen won't do it, so left this here with
-	// &thinsp; for when I do figure out how to do it with &#8203;)
-	FString packageNameBreaks = packageName.Replace(TEXT("/"), TEXT("&thinsp;/"));
-	//packageName = packageName.Replace(TEXT("/"), TEXT("&zwnj;/"));
-
-	bool isDeprecated = false;
-	FString sDeprecated = "This material will be removed in future versions.";
+	materialHeaderData header;
+	header.className = className;
+	header.parentClass = parentClass;
+	header.packageName = packageName;
+	header.brief = FString::Printf(TEXT("A material with %d graphs."), graphCount);
+	header.imageTag = imageTag;
 
 	// The (default) config file where public values can be saved/referenced.
-	FString config = getTrimmedConfigFilePath(material->GetDefaultConfigFilename());
+	header.config = getTrimmedConfigFilePath(material->GetDefaultConfigFilename());
 
 	// material domain
 	FString domain;
 	UEnum::GetValueAsString(material->MaterialDomain,domain);
 	domain.RemoveFromStart("MD_");
+	header.domain = domain;
 
 	// TODO: no information is available as provided by the user/package.
 	// the only place I found is as a rootNode comment bubble, but it always seems empty.
@@ -437,7 +557,21 @@ void materialReporter::writeMaterialHeader(
 	description += material->GetDesc() + "\n";
 	//description += "	" + material->GetDetailedInfo();
 	description += "	" + material->MaterialGraph->RootNode->NodeComment;
-	description = description.TrimStartAndEnd();
+	header.description = description.TrimStartAndEnd();
+
+	writeMaterialHeader(header, group, qualifier);
+}
+
+void materialReporter::writeMaterialHeader(materialHeaderData const& header, FString group, FString qualifier)
+{
+	// Gives the line places to break if needed.
+	// TODO: (actually turns out doxygen won't do it, so left this here with
+	// &thinsp; for when I do figure out how to do it with &#8203;)
+	FString packageNameBreaks = header.packageName.Replace(TEXT("/"), TEXT("&thinsp;/"));
+	//packageName = packageName.Replace(TEXT("/"), TEXT("&zwnj;/"));
+
+	bool isDeprecated = false;
+	FString sDeprecated = "This material will be removed in future versions.";
 
 	*out << "#pragma once" << endl;
 	*out << "/**" << endl;
@@ -449,27 +583,29 @@ void materialReporter::writeMaterialHeader(
 	//if (isDeprecated)
 	//	*out << "	\\deprecated " << *sDeprecated << endl;
 
-	*out << "	\\brief A material with " << graphCount << " graphs." << endl;
+	*out << "	\\brief " << *header.brief << endl;
 	*out << endl;
 
-	if (!imageTag.IsEmpty())
-		*out << "	" << *imageTag << endl;
+	if (!header.imageTag.IsEmpty())
+		*out << "	" << *header.imageTag << endl;
 
 	*out << "	UDF Path: <b>" << *packageNameBreaks << "</b>" << endl;
-	*out << "	<br/>Config: <b>" << *config << "</b>" << endl;
-	*out << "	<br/>Domain: <b>" << *domain << "</b>" << endl;
+	*out << "	<br/>Config: <b>" << *header.config << "</b>" << endl;
+
+	if (!header.domain.IsEmpty())
+		*out << "	<br/>Domain: <b>" << *header.domain << "</b>" << endl;
 
-	if (!description.IsEmpty())
+	if (!header.description.IsEmpty())
 	{
 		*out << "	" << endl;
-		*out << "	" << *description << endl;
+		*out << "	" << *header.description << endl;
 	}
 
 	//*out << "	<div style='clear:both;'/>" << endl;	//now a css thing elsewhere
 
-	*out << "	\\headerfile " << *className << ".h \"" << *packageName << "\"" << endl;
+	*out << "	\\headerfile " << *header.className << ".h \"" << *header.packageName << "\"" << endl;
 	*out << "*/" << endl;
-	*out << "class " << *className << " : public " << *parentClass << endl;
+	*out << "class " << *header.className << " : public " << *header.parentClass << endl;
 	*out << "{" << endl;
 }
 
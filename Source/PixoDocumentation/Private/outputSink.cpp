@@ -0,0 +1,147 @@
+// (c) 2023 PixoVR
+
+#include "outputSink.h"
+#include "fileWriter.h"
+
+outputSink::outputSink()
+{
+}
+
+outputSink::~outputSink()
+{
+	close();
+}
+
+/**
+ * @brief Start building a file.
+ * @param _path The file, which is written by close()
+ * @param _append Add to the end of the file, instead of replacing it
+ * @param _writer Where to hand the file on close(), or NULL to write it there and then
+ * @return true.  The file isn't touched until close().
+ */
+
+bool outputSink::open(FString _path, bool _append, fileWriter* _writer)
+{
+	close();
+
+	path = _path;
+	appendToFile = _append;
+	writer = _writer;
+	buffer.Reset();			//keeps its allocation, unless it went to a writer
+
+	return true;
+}
+
+void outputSink::openStdout()
+{
+	close();
+}
+
+/**
+ * @brief Write the file built since open(), or hand it to the writer.
+ * @return false if there was no file, or it could not be written.
+ */
+
+bool outputSink::close()
+{
+	if (path.IsEmpty() && !line.IsEmpty())
+		newline();
+
+	if (path.IsEmpty())
+		return false;
+
+	bool ok = true;
+	if (writer)
+		writer->write(MoveTemp(buffer), path, appendToFile);
+	else
+		ok = fileWriter::writeFile(buffer.GetData(), buffer.Num(), path, appendToFile);
+
+	path.Empty();
+	writer = NULL;
+	buffer.Reset();
+
+	return ok;
+}
+
+outputSink& outputSink::operator<<(const TCHAR* s)
+{
+	append(s, FCString::Strlen(s));
+	return *this;
+}
+
+outputSink& outputSink::operator<<(const ANSICHAR* s)
+{
+	append(ANSI_TO_TCHAR(s), FCStringAnsi::Strlen(s));
+	return *this;
+}
+
+outputSink& outputSink::operator<<(FString const& s)
+{
+	append(*s, s.Len());
+	return *this;
+}
+
+outputSink& outputSink::operator<<(int32 v)
+{
+	return *this << FString::FromInt(v);
+}
+
+outputSink& outputSink::operator<<(std::wostream& (*manip)(std::wostream&))
+{
+	//endl is the only manipulator used
+	newline();
+	return *this;
+}
+
+void outputSink::append(const TCHAR* s, int32 len)
+{
+	if (path.IsEmpty())
+	{
+		//stdout, a line at a time
+		for (int32 i = 0; i < len; i++)
+		{
+			if (s[i] == '\n')
+				newline();
+			else
+				line.AppendChar(s[i]);
+		}
+		return;
+	}
+
+	buffer.Reserve(buffer.Num() + len);
+
+	for (int32 i = 0; i < len; i++)
+	{
+		TCHAR c = s[i];
+		if (c >= 0x80)
+		{
+			int32 j = i;
+			while (j < len && s[j] >= 0x80)
+				j++;
+
+			FTCHARToUTF8 utf8(s + i, j - i);
+			buffer.Append((const uint8*)utf8.Get(), utf8.Length());
+
+			i = j - 1;
+			continue;
+		}
+
+#if PLATFORM_WINDOWS
+		if (c == '\n')
+			buffer.Add('\r');		//text mode, as the std::wofstream was
+#endif
+		buffer.Add((uint8)c);
+	}
+}
+
+void outputSink::newline()
+{
+	if (!path.IsEmpty())
+	{
+		append(TEXT("\n"), 1);
+		return;
+	}
+
+	std::wcout << TCHAR_TO_WCHAR(*line) << std::endl;
+	line.Reset();
+}
@@ -0,0 +1,138 @@
+// (c) 2023 PixoVR
+
+#include "packagePrefetcher.h"
+
+#include "UObject/UObjectGlobals.h"
+#if ENGINE_MAJOR_VERSION >= 5
+#include "Misc/PackagePath.h"
+#endif
+
+/**
+ * @brief packagePrefetcher::packagePrefetcher
+ * @param _assets The assets to load, in the order they should be requested.
+ * @param _window The number of packages allowed in flight.  0 disables prefetching.
+ */
+
+packagePrefetcher::packagePrefetcher(TArray<FAssetData> const& _assets, int32 _window)
+: assets(_assets)
+, window(FMath::Max(_window, 0))
+{
+#if ENGINE_MAJOR_VERSION < 5
+	//no way to pass LOAD_DisableCompileOnLoad, and blueprints would be compiled on load
+	window = 0;
+#endif
+
+	issue();
+}
+
+packagePrefetcher::~packagePrefetcher()
+{
+	//don't leave anything loading behind us
+	flush();
+
+	for (TSharedPtr<request>& r : inflight)
+		release(r);
+}
+
+/**
+ * @brief Get the next asset, once its package has finished loading.
+ * @param asset Receives the asset.
+ * @return false when there is nothing left.
+ *
+ * Assets come back in the order they were given, so output and logs don't
+ * depend on which package happens to load first.  This blocks on the oldest
+ * request only, while the rest of the window keeps loading.
+ */
+
+bool packagePrefetcher::next(FAssetData& asset)
+{
+	if (window == 0)
+	{
+		if (nextIndex >= assets.Num())
+			return false;
+
+		asset = assets[nextIndex++];
+		return true;
+	}
+
+	issue();
+
+	if (inflight.Num() == 0)
+		return false;
+
+	TSharedPtr<request> r = inflight[0];
+	if (!r->done)
+		FlushAsyncLoading(r->requestId);
+
+	inflight.RemoveAt(0);
+	release(r);				//the caller holds it from here, and GC only runs between assets
+
+	//a failed request is reported by the caller's synchronous load
+	asset = assets[r->index];
+
+	issue();				//keep the window full while the caller emits
+
+	return true;
+}
+
+/**
+ * @brief Wait for every outstanding request.
+ */
+
+void packagePrefetcher::flush()
+{
+	for (TSharedPtr<request>& r : inflight)
+	{
+		if (!r->done)
+			FlushAsyncLoading(r->requestId);
+	}
+}
+
+void packagePrefetcher::issue()
+{
+#if ENGINE_MAJOR_VERSION >= 5
+	while (inflight.Num() < window && nextIndex < assets.Num())
+	{
+		TSharedPtr<request> r = MakeShared<request>();
+		r->index = nextIndex;
+
+		FName packageName = assets[nextIndex].PackageName;
+		nextIndex++;
+
+		r->requestId = LoadPackageAsync(
+			FPackagePath::FromPackageNameChecked(packageName),
+			NAME_None,
+			FLoadPackageAsyncDelegate::CreateLambda(
+				[r](const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+				{
+					r->done = true;
+					r->succeeded = (Result == EAsyncLoadingResult::Succeeded) && LoadedPackage;
+
+					//keep it through any garbage collection until it is handed back
+					if (r->succeeded && !LoadedPackage->IsRooted())
+					{
+						LoadedPackage->AddToRoot();
+						r->package = LoadedPackage;
+					}
+				}
+			),
+			PKG_None,
+			INDEX_NONE,
+			0,
+			nullptr,
+			LOAD_NoWarn | LOAD_DisableCompileOnLoad
+		);
+
+		inflight.Add(r);
+	}
+#endif
+}
+
+void packagePrefetcher::release(TSharedPtr<request>& r)
+{
+	if (r->package)
+	{
+		r->package->RemoveFromRoot();
+		r->package = NULL;
+	}
+}
@@ -0,0 +1,413 @@
+// (c) 2023 PixoVR
+
+#include "reportManifest.h"
+
+#include "Runtime/Launch/Resources/Version.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/SecureHash.h"
+#include "HAL/FileManager.h"
+#include "Interfaces/IPluginManager.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+#include "reporter.h"
+
+/**
+ * @brief reportManifest::reportManifest
+ * @param _path The manifest file
+ * @param _outputDir The output directory that recorded files are relative to
+ * @param _stylesheet The stylesheet, which is embedded in every output file
+ */
+
+reportManifest::reportManifest(FString _path, FString _outputDir, FString _stylesheet)
+: path(_path)
+, outputDir(_outputDir)
+, stylesheet(_stylesheet)
+{
+	TSharedPtr<IPlugin> plugin = IPluginManager::Get().FindPlugin(TEXT("PixoDocumentation"));
+	if (plugin.IsValid())
+		version = plugin->GetDescriptor().VersionName;
+}
+
+reportManifest::~reportManifest()
+{
+}
+
+/**
+ * @brief Read the manifest from the last run.
+ * @return false if there was a manifest but it could not be read.
+ *
+ * A missing manifest, or one written by another plugin version or with
+ * another stylesheet, is treated as empty.
+ */
+
+bool reportManifest::load()
+{
+	entries.Empty();
+	loaded = false;
+
+	FString json;
+	if (!FFileHelper::LoadFileToString(json, *path))
+		return true;				//first run
+
+	TSharedPtr<FJsonObject> root;
+	TSharedRef<TJsonReader<>> reader = TJsonReaderFactory<>::Create(json);
+	if (!FJsonSerializer::Deserialize(reader, root) || !root.IsValid())
+	{
+		UE_LOG(LOG_DOT, Warning, TEXT("Could not parse manifest '%s'."), *path);
+		return false;
+	}
+
+	if (root->GetStringField(TEXT("version")) != version ||
+		root->GetStringField(TEXT("stylesheet")) != stylesheet)
+	{
+		UE_LOG(LOG_DOT, Display, TEXT("Plugin version or stylesheet changed.  Regenerating everything."));
+		full = true;
+	}
+
+	loaded = true;
+
+	const TSharedPtr<FJsonObject>* packages = NULL;
+	if (!root->TryGetObjectField(TEXT("packages"), packages))
+		return true;
+
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& p : (*packages)->Values)
+	{
+		const TSharedPtr<FJsonObject>& jp = p.Value->AsObject();
+		if (!jp.IsValid())
+			continue;
+
+		entry& e = entries.Add(FName(*p.Key));
+		e.hash = jp->GetStringField(TEXT("hash"));
+		e.fileHash = jp->GetStringField(TEXT("file"));
+		e.size = FCString::Atoi64(*jp->GetStringField(TEXT("size")));
+		e.timestamp = FDateTime(FCString::Atoi64(*jp->GetStringField(TEXT("ticks"))));
+
+		for (const TSharedPtr<FJsonValue>& v : jp->GetArrayField(TEXT("files")))
+			e.files.Add(v->AsString());
+
+		for (const TSharedPtr<FJsonValue>& v : jp->GetArrayField(TEXT("gallery")))
+			e.gallery.Add(v->AsString());
+	}
+
+	UE_LOG(LOG_DOT, Display, TEXT("Read %d package(s) from the manifest."), entries.Num());
+
+	return true;
+}
+
+/**
+ * @brief Write the manifest for the next run.
+ * @return false if it could not be written.
+ */
+
+bool reportManifest::save()
+{
+	TSharedPtr<FJsonObject> packages = MakeShared<FJsonObject>();
+
+	for (const TPair<FName, entry>& p : entries)
+	{
+		const entry& e = p.Value;
+
+		TSharedPtr<FJsonObject> jp = MakeShared<FJsonObject>();
+		jp->SetStringField(TEXT("hash"), e.hash);
+		jp->SetStringField(TEXT("file"), e.fileHash);
+		jp->SetStringField(TEXT("size"), LexToString(e.size));			//int64 doesn't survive a json double
+		jp->SetStringField(TEXT("ticks"), LexToString(e.timestamp.GetTicks()));
+
+		TArray<TSharedPtr<FJsonValue>> jfiles;
+		for (const FString& f : e.files)
+			jfiles.Add(MakeShared<FJsonValueString>(f));
+		jp->SetArrayField(TEXT("files"), jfiles);
+
+		TArray<TSharedPtr<FJsonValue>> jgallery;
+		for (const FString& g : e.gallery)
+			jgallery.Add(MakeShared<FJsonValueString>(g));
+		jp->SetArrayField(TEXT("gallery"), jgallery);
+
+		packages->SetObjectField(p.Key.ToString(), jp);
+	}
+
+	TSharedPtr<FJsonObject> root = MakeShared<FJsonObject>();
+	root->SetStringField(TEXT("version"), version);
+	root->SetStringField(TEXT("stylesheet"), stylesheet);
+	root->SetObjectField(TEXT("packages"), packages);
+
+	FString json;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+	FJsonSerializer::Serialize(root.ToSharedRef(), writer);
+
+	if (!FFileHelper::SaveStringToFile(json, *path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not open '%s' for writing."), *path);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Re-hash a package, if its file has been touched since it was last seen.
+ * @param packageName The long package name
+ * @return true if the package is new, changed, or now missing.
+ */
+
+bool reportManifest::refresh(FName packageName)
+{
+	entry& e = entries.FindOrAdd(packageName);
+	if (e.refreshed)
+		return false;
+
+	e.refreshed = true;
+
+	FString lastHash = e.fileHash;
+	FString filename = getPackageFilename(packageName);
+	FFileStatData stat;
+	if (!filename.IsEmpty())
+		stat = IFileManager::Get().GetStatData(*filename);
+
+	if (!stat.bIsValid)
+	{
+		e.fileHash.Empty();
+		return !lastHash.IsEmpty();
+	}
+
+	if (!lastHash.IsEmpty() && stat.FileSize == e.size && stat.ModificationTime == e.timestamp)
+		return false;
+
+	FMD5Hash md5 = FMD5Hash::HashFile(*filename);
+	e.fileHash = md5.IsValid() ? LexToString(md5) : FString();
+	e.size = stat.FileSize;
+	e.timestamp = stat.ModificationTime;
+
+	return e.fileHash != lastHash || e.fileHash.IsEmpty();
+}
+
+/**
+ * @brief Emit a package again, even if its own file is unchanged.
+ * @param packageName The long package name
+ *
+ * Used for packages that reference something that changed.  This is
+ * recorded in the manifest, so it still happens if this run doesn't finish.
+ */
+
+void reportManifest::forceDirty(FName packageName)
+{
+	entry* e = entries.Find(packageName);
+	if (e)
+		e->hash.Empty();
+}
+
+/**
+ * @brief Whether an asset's package is unchanged since it was last emitted.
+ * @param asset The asset to check
+ * @return true if it can be skipped.
+ */
+
+bool reportManifest::isUpToDate(FAssetData const& asset)
+{
+	refresh(asset.PackageName);
+
+	const entry& e = entries.FindChecked(asset.PackageName);
+
+	if (full || e.hash.IsEmpty() || e.hash != e.fileHash)
+		return false;
+
+	numUnchanged++;
+	return true;
+}
+
+TArray<FString> reportManifest::getGallery(FName packageName) const
+{
+	const entry* e = entries.Find(packageName);
+	return e ? e->gallery : TArray<FString>();
+}
+
+/**
+ * @brief Start recording the output of a package.
+ * @param packageName The package about to be emitted
+ *
+ * The package stays out of date until finish() is called, so an asset that
+ * fails part way through is tried again next run.
+ */
+
+void reportManifest::begin(FName packageName)
+{
+	current = packageName;
+
+	entry& e = entries.FindOrAdd(current);
+	previousFiles = e.files;
+	e.hash.Empty();
+	e.files.Empty();
+	e.gallery.Empty();
+}
+
+void reportManifest::addFile(FString fpath)
+{
+	if (current.IsNone())
+		return;
+
+	entries.FindOrAdd(current).files.AddUnique(getRelativePath(fpath));
+}
+
+void reportManifest::addGallery(FString galleryEntry)
+{
+	if (current.IsNone())
+		return;
+
+	entries.FindOrAdd(current).gallery.AddUnique(galleryEntry);
+}
+
+/**
+ * @brief The current package was emitted completely.
+ * @param upToDate false to still emit it again next run (eg: after an index)
+ *
+ * Its hash is recorded, and any file it produced last time but not this
+ * time (eg: a renamed class) is deleted.
+ */
+
+void reportManifest::finish(bool upToDate)
+{
+	if (current.IsNone())
+		return;
+
+	entry& e = entries.FindOrAdd(current);
+	if (upToDate)
+		e.hash = e.fileHash;
+
+	for (const FString& f : previousFiles)
+	{
+		if (!e.files.Contains(f) && deleteFile(f))
+			numDeleted++;
+	}
+
+	previousFiles.Empty();
+	current = NAME_None;
+}
+
+/**
+ * @brief The current package failed part way through.
+ *
+ * It stays out of date, and keeps the files it produced last time as well
+ * as any written this time, so a later finish() or prune() still cleans
+ * them all up.
+ */
+
+void reportManifest::cancel()
+{
+	if (current.IsNone())
+		return;
+
+	entry& e = entries.FindOrAdd(current);
+	e.hash.Empty();
+
+	for (const FString& f : previousFiles)
+		e.files.AddUnique(f);
+
+	previousFiles.Empty();
+	current = NAME_None;
+}
+
+/**
+ * @brief A file recorded for a package was not written after all.
+ * @param fpath The file, as it was written
+ * @return false if no package produced it.
+ *
+ * Writes finish in the background, after their package has been finished,
+ * so a failed write is reported here instead.  The package that produced
+ * the file is left out of date, and emitted again next run.
+ */
+
+bool reportManifest::invalidateFile(FString fpath)
+{
+	FString relPath = getRelativePath(fpath);
+	bool found = false;
+
+	for (TPair<FName, entry>& It : entries)
+	{
+		if (It.Value.files.Contains(relPath))
+		{
+			It.Value.hash.Empty();
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+/**
+ * @brief Delete the outputs of packages that no longer exist.
+ * @param discovered Every package found by discovery this run, in any shard
+ * @param removed Receives the packages removed
+ * @return The number of packages removed.
+ */
+
+int32 reportManifest::prune(TSet<FName> const& discovered, TArray<FName>& removed)
+{
+	for (TMap<FName, entry>::TIterator It(entries); It; ++It)
+	{
+		if (discovered.Contains(It.Key()))
+			continue;
+
+		removed.Add(It.Key());
+
+		for (const FString& f : It.Value().files)
+		{
+			if (deleteFile(f))
+				numDeleted++;
+		}
+
+		It.RemoveCurrent();
+	}
+
+	if (removed.Num())
+		UE_LOG(LOG_DOT, Display, TEXT("Removed the output of %d package(s) that no longer exist."), removed.Num());
+
+	return removed.Num();
+}
+
+/**
+ * @brief The on-disk file of a package.
+ * @param packageName The long package name
+ * @return The filename, or empty if the package doesn't exist.
+ */
+
+FString reportManifest::getPackageFilename(FName packageName)
+{
+	FString filename;
+
+#if ENGINE_MAJOR_VERSION >= 5
+	if (!FPackageName::DoesPackageExist(packageName.ToString(), &filename))
+#else
+	if (!FPackageName::DoesPackageExist(packageName.ToString(), NULL, &filename))
+#endif
+		return "";
+
+	return filename;
+}
+
+FString reportManifest::getRelativePath(FString fpath) const
+{
+	FPaths::NormalizeFilename(fpath);
+
+	FString dir = outputDir;
+	FPaths::NormalizeDirectoryName(dir);
+
+	fpath.RemoveFromStart(dir + "/");
+	return fpath;
+}
+
+bool reportManifest::deleteFile(FString relPath)
+{
+	FString fpath = outputDir + "/" + relPath;
+	FPaths::MakePlatformFilename(fpath);
+
+	if (!IFileManager::Get().FileExists(*fpath))
+		return false;
+
+	UE_LOG(LOG_DOT, Display, TEXT(" Deleting  [OutputDir]/%s"), *relPath);
+
+	return IFileManager::Get().Delete(*fpath);
+}
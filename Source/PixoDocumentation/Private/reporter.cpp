@@ -1,6 +1,9 @@
 // (c) 2023 PixoVR
 
 #include "reporter.h"
+#include "packagePrefetcher.h"
+#include "reportManifest.h"
+#include "galleryAtlas.h"
 
 #include "Runtime/Launch/Resources/Version.h"
 
@@ -18,15 +21,33 @@
 #include "MaterialGraph/MaterialGraphSchema.h"
 
 #include "ThumbnailRendering/ThumbnailManager.h"
+#include "ObjectTools.h"
 #include "IImageWrapperModule.h"
 #include "IImageWrapper.h"
 //#include "UObject/UObjectThreadContext.h"
+#include "HAL/FileManager.h"
+#include "UObject/PackageFileSummary.h"
 #include "Misc/FileHelper.h"
+#include "Misc/SecureHash.h"
+#include "HAL/PlatformMemory.h"
+#include "UObject/UObjectHash.h"
 
 
 TArray<FString> reporter::IgnoreFolders;
 TArray<FString> reporter::IncludeFolders;
-TArray<FString> reporter::GroupList;
+folderTrie reporter::Folders;
+TArray<reportGroupData> reporter::GroupList;
+int32 reporter::PrefetchWindow = 8;
+int32 reporter::MemoryBudgetMB = 0;
+uint64 reporter::PeakMemoryMB = 0;
+int32 reporter::NumGCPasses = 0;
+TArray<TWeakObjectPtr<UPackage>> reporter::ReleasedPackages;
+reportManifest* reporter::Manifest = NULL;
+fileWriter* reporter::Writer = NULL;
+FString reporter::ThumbnailCacheDir = "";
+bool reporter::IndexOnly = false;
+
+static IImageWrapperModule* ThumbnailEncoder = NULL;		//resolved once, on the game thread
 
 /**
  * @brief The base class for reporters.
@@ -47,133 +68,222 @@ reporter::reporter(FString _reportType, FString _outputDir, FString _stylesheet,
 , stylesheet(_stylesheet)
 , groups(_groups)
 , outputDir(_outputDir)
+, NodeStyle(&BaseStyle)
 {
-	NodeStyle.Empty();
-	NodeStyle.Add("_STYLESHEET_", stylesheet);
-	NodeStyle.Add("_GRAPHBG_", "transparent");
-	//NodeStyle.Add("_GRAPHBG_", "#F1F1F1");	//can't do it this way.  Use css instead.
-	NodeStyle.Add("_FONTNAME_", "Arial");
-	//NodeStyle.Add("_FONTNAME_", "Helvetica");
-	NodeStyle.Add("_FONTSIZE_", "10");		//for header/title
-	NodeStyle.Add("_FONTSIZE2_", "9");		//for header/title2
-	NodeStyle.Add("_FONTCOLOR_", "black");		//for header/title
-	NodeStyle.Add("_FONTSIZEPORT_", "10");		//for pins
-	NodeStyle.Add("_FONTSIZECOMMENT_", "18");	//comment size
-	NodeStyle.Add("_FONTSIZEBUBBLE_", "11");	//bubble text size
-	NodeStyle.Add("_FONTCOLORBUBBLE_", "#888888");	//bubble font color
-	NodeStyle.Add("_NODECOLOR_", "#F8F9FA");
-	NodeStyle.Add("_NODECOLORTRANS_", "#F8F9FAEE");
-	NodeStyle.Add("_VALCOLOR_", "#888888");
-	NodeStyle.Add("_BORDERCOLOR_", "#999999");
-	NodeStyle.Add("_EDGECOLOR_", "#444444");
-	NodeStyle.Add("_EDGETHICKNESS_", "2");
-	NodeStyle.Add("_PINDEFAULTCOLOR_", "#444444");
-	NodeStyle.Add("_PINURL_", "");
-	NodeStyle.Add("_CELLPADDING_", "3");
-	NodeStyle.Add("_COMMENTPADDING_", "7");
-	NodeStyle.Add("_COMPOSITEPADDING_", "4");	// 5 ?
-	NodeStyle.Add("_COMPACTCOLOR_", "#888888");
-	NodeStyle.Add("_COMPACTSIZE_", "16");
-	NodeStyle.Add("_COMPACTWIDTH_", "100");
-
-	NodeStyle.Add("_HEIGHTSPACER_", "<font color=\"transparent\" point-size=\"12\">&thinsp;</font>");
+	BaseStyle.set(StyleKey::STYLESHEET, stylesheet);
+	BaseStyle.set(StyleKey::GRAPHBG, "transparent");
+	//BaseStyle.set(StyleKey::GRAPHBG, "#F1F1F1");	//can't do it this way.  Use css instead.
+	BaseStyle.set(StyleKey::FONTNAME, "Arial");
+	//BaseStyle.set(StyleKey::FONTNAME, "Helvetica");
+	BaseStyle.set(StyleKey::FONTSIZE, "10");		//for header/title
+	BaseStyle.set(StyleKey::FONTSIZE2, "9");		//for header/title2
+	BaseStyle.set(StyleKey::FONTCOLOR, "black");		//for header/title
+	BaseStyle.set(StyleKey::FONTSIZEPORT, "10");		//for pins
+	BaseStyle.set(StyleKey::FONTSIZECOMMENT, "18");	//comment size
+	BaseStyle.set(StyleKey::FONTSIZEBUBBLE, "11");	//bubble text size
+	BaseStyle.set(StyleKey::FONTCOLORBUBBLE, "#888888");	//bubble font color
+	BaseStyle.set(StyleKey::NODECOLOR, "#F8F9FA");
+	BaseStyle.set(StyleKey::NODECOLORTRANS, "#F8F9FAEE");
+	BaseStyle.set(StyleKey::VALCOLOR, "#888888");
+	BaseStyle.set(StyleKey::BORDERCOLOR, "#999999");
+	BaseStyle.set(StyleKey::EDGECOLOR, "#444444");
+	BaseStyle.set(StyleKey::EDGETHICKNESS, "2");
+	BaseStyle.set(StyleKey::PINDEFAULTCOLOR, "#444444");
+	BaseStyle.set(StyleKey::PINURL, "");
+	BaseStyle.set(StyleKey::CELLPADDING, "3");
+	BaseStyle.set(StyleKey::COMMENTPADDING, "7");
+	BaseStyle.set(StyleKey::COMPOSITEPADDING, "4");	// 5 ?
+	BaseStyle.set(StyleKey::COMPACTCOLOR, "#888888");
+	BaseStyle.set(StyleKey::COMPACTSIZE, "16");
+	BaseStyle.set(StyleKey::COMPACTWIDTH, "100");
+
+	BaseStyle.set(StyleKey::HEIGHTSPACER, "<font color=\"transparent\" point-size=\"12\">&thinsp;</font>");
 
 	//outputDir = "-";			//comment this line when not debugging
 	if (outputDir == "-")
-		out = &std::wcout;
+	{
+		output.openStdout();
+		out = &output;
+	}
 	//else
 	//	LOG("Output Directory: "+outputDir);
 
-	//loadAssets();
 }
 
 reporter::~reporter()
 {
 }
 
-#if ENGINE_MAJOR_VERSION >= 5
-void reporter::loadAssetsByPath(FTopLevelAssetPath loadPath)
-{
-	LOG("Loading Asset Class: " + loadPath.ToString() + "...");
-
-	FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(AssetRegistryConstants::ModuleName);
-	AssetRegistryModule.Get().SearchAllAssets(/*bSynchronousSearch =*/true);
-	AssetRegistryModule.Get().GetAssetsByClass(FTopLevelAssetPath(loadPath), assetList, true);
+/**
+ * @brief Set the assets this reporter will walk.
+ * @param assets The asset list, usually discovered once by PixoDocumentation.
+ *
+ * Reporters no longer scan the asset registry themselves.  A single
+ * include-scoped scan is done by PixoDocumentation::discoverAssets() and
+ * the results are handed to every reporter.
+ */
 
-	LOG(FString::Printf(TEXT("Found %d %s instances in asset registry."), assetList.Num(), *loadPath.ToString()));
-}
-#else
-void reporter::loadAssets(FName loadClass)
+void reporter::setAssetList(TArray<FAssetData> const& assets)
 {
-	LOG("Loading Asset Class: " + loadClass.ToString() + "...");
-
-	FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(AssetRegistryConstants::ModuleName);
-	AssetRegistryModule.Get().SearchAllAssets(/*bSynchronousSearch =*/true);
-	AssetRegistryModule.Get().GetAssetsByClass(loadClass, assetList, true);
+	assetList = assets;
 
-	LOG(FString::Printf(TEXT("Found %d %s instances in asset registry."), assetList.Num(), *loadClass.ToString()));
+	LOG(FString::Printf(TEXT("Using %d %s asset(s) from the asset registry."), assetList.Num(), *reportType));
 }
-#endif
+
+/**
+ * @brief Report every asset, in the verbose/debug format.
+ * @param graphCount Incremented by the graphs reported
+ * @param ignoredCount Incremented by the assets ignored
+ * @param failedCount Incremented by the assets that failed to load
+ *
+ * The asset class is known from the registry, so each asset is loaded once,
+ * with the same flags as its doxygen reporter, and handed to the matching
+ * report function.
+ */
 
 void reporter::report(int &graphCount, int &ignoredCount, int &failedCount)
 {
 	LOG( "Parsing " + reportType + "..." );
 
-#if ENGINE_MAJOR_VERSION >= 5
-	loadAssetsByPath(FTopLevelAssetPath(UBlueprint::StaticClass()->GetPathName()));		//BlueprintBaseClassName
-	loadAssetsByPath(FTopLevelAssetPath(UMaterialInterface::StaticClass()->GetPathName()));	//MaterialBaseClassName
-#else
-	loadAssets(UBlueprint::StaticClass()->GetFName());		//BlueprintBaseClassName
-	loadAssets(UMaterialInterface::StaticClass()->GetFName());	//MaterialBaseClassName
-#endif
-
+	TArray<FAssetData> assets;
 	for (FAssetData const& Asset : assetList)
 	{
 		if (shouldReportAsset(Asset))
-		{
+			assets.Add(Asset);
+		else
+			ignoredCount++;
+	}
+
+	packagePrefetcher prefetcher(assets, PrefetchWindow);
+
+	FAssetData Asset;
+	while (prefetcher.next(Asset))
+	{
 #if ENGINE_MAJOR_VERSION >= 5
-			FString const AssetPath = Asset.GetObjectPathString();
+		FString const AssetPath = Asset.GetObjectPathString();
 #else
-			FString const AssetPath = Asset.ObjectPath.ToString();
+		FString const AssetPath = Asset.ObjectPath.ToString();
 #endif
-			FString const AssetName = Asset.AssetName.ToString();
-			FString const PackagePath = Asset.PackagePath.ToString();
+		FString const AssetName = Asset.AssetName.ToString();
+		FString const PackagePath = Asset.PackagePath.ToString();
+
+		UE_LOG(LOG_DOT, Warning, TEXT("Loading Asset:   '%s'..."), *AssetPath);
+		UE_LOG(LOG_DOT, Warning, TEXT("Loading Package: '%s'..."), *PackagePath);
+		UE_LOG(LOG_DOT, Warning, TEXT("Asset name: '%s'..."), *AssetName);
 
-			UE_LOG(LOG_DOT, Warning, TEXT("Loading Asset:   '%s'..."), *AssetPath);
-			UE_LOG(LOG_DOT, Warning, TEXT("Loading Package: '%s'..."), *PackagePath);
-			UE_LOG(LOG_DOT, Warning, TEXT("Asset name: '%s'..."), *AssetName);
+		//the registry knows the class, which is native and already loaded
+		UClass* assetClass = Asset.GetClass();
+		bool isBlueprint = assetClass && assetClass->IsChildOf(UBlueprint::StaticClass());
+		bool isMaterial = assetClass && assetClass->IsChildOf(UMaterialInterface::StaticClass());
 
+		UObject* LoadedObject = NULL;
+		if (isBlueprint || isMaterial)
+		{
 			//Load with LOAD_NoWarn and LOAD_DisableCompileOnLoad.
-			UBlueprint* LoadedBlueprint = Cast<UBlueprint>(StaticLoadObject(Asset.GetClass(), /*Outer =*/nullptr, *AssetPath, nullptr, LOAD_NoWarn | LOAD_DisableCompileOnLoad));
-			UMaterialInterface* LoadedMaterial = Cast<UMaterialInterface>(StaticLoadObject(Asset.GetClass(), /*Outer =*/nullptr, *AssetPath, nullptr, LOAD_None));
+			LoadedObject = StaticLoadObject(assetClass, /*Outer =*/nullptr, *AssetPath, nullptr, LOAD_NoWarn | LOAD_DisableCompileOnLoad);
+		}
 
-			if (!LoadedBlueprint && !LoadedMaterial)
-			{
-				failedCount++;
-				UE_LOG(LOG_DOT, Error, TEXT("%sFailed to Load : '%s'."), *_tab, *AssetPath);
-				continue;
-			}
-			else
-			{
-				if (LoadedBlueprint)
-					reportBlueprint(_tab, LoadedBlueprint);
+		UBlueprint* LoadedBlueprint = isBlueprint ? Cast<UBlueprint>(LoadedObject) : NULL;
+		UMaterialInterface* LoadedMaterial = isMaterial ? Cast<UMaterialInterface>(LoadedObject) : NULL;
 
-				if (LoadedMaterial)
-					reportMaterial(_tab, LoadedMaterial);
-			}
+		if (!LoadedBlueprint && !LoadedMaterial)
+		{
+			failedCount++;
+			UE_LOG(LOG_DOT, Error, TEXT("%sFailed to Load : '%s'."), *_tab, *AssetPath);
+			continue;
 		}
 		else
-			ignoredCount++;
+		{
+			if (LoadedBlueprint)
+				graphCount += FMath::Max(reportBlueprint(_tab, LoadedBlueprint), 0);
+
+			if (LoadedMaterial)
+				graphCount += FMath::Max(reportMaterial(_tab, LoadedMaterial), 0);
+		}
+
+		trackMemory(prefetcher, LoadedObject->GetPackage());
 	}
 }
 
+/**
+ * @brief Add a group, with the current gallery, to reporter::GroupList.
+ * @param groupName The doxygen group name
+ * @param groupNamePretty The cosmetic group name
+ * @param brief The group brief
+ * @param details The group details
+ *
+ * Nothing is written here.  PixoDocumentation writes the groups file (or the
+ * shard state) once every reporter is done, so concurrent shards never touch
+ * a shared file.  Reporting the same group twice merges the galleries.
+ */
+
 void reporter::reportGroup(FString groupName, FString groupNamePretty, FString brief, FString details)
 {
-	if (GroupList.Contains(groupName))
-		return;
+	reportGroupData* group = findGroup(groupName);
+
+	if (!group)
+	{
+		group = &GroupList.AddDefaulted_GetRef();
+		group->name = groupName;
+		group->namePretty = groupNamePretty;
+		group->brief = brief;
+		group->details = details;
+	}
+
+	for (const FString& e : GalleryList)
+		group->gallery.AddUnique(e);
+
+	GalleryList.Empty();		//reset the gallery
+}
+
+/**
+ * @brief Add an image entry to the current gallery.
+ * @param galleryEntry The doxygen markup for the entry
+ *
+ * The entry is also recorded in the manifest, so the gallery can be rebuilt
+ * when the asset is skipped next time.
+ */
+
+void reporter::addGalleryEntry(FString galleryEntry)
+{
+	GalleryList.Add(galleryEntry);
+
+	if (Manifest)
+		Manifest->addGallery(galleryEntry);
+}
+
+/**
+ * @brief Skip an asset that hasn't changed since it was last emitted.
+ * @param Asset The asset to check
+ * @return true if the manifest says its output is up to date.
+ *
+ * The output files are left alone, and the gallery entries from the last
+ * run are added back to the current gallery.
+ */
+
+bool reporter::skipUnchanged(FAssetData const& Asset)
+{
+	if (!Manifest || !Manifest->isUpToDate(Asset))
+		return false;
 
-	GroupList.Add(groupName);
+	GalleryList.Append(Manifest->getGallery(Asset.PackageName));
 
+	return true;
+}
+
+reportGroupData* reporter::findGroup(FString groupName)
+{
+	return GroupList.FindByPredicate([&groupName](const reportGroupData& g) { return g.name == groupName; });
+}
+
+/**
+ * @brief Format a group as a doxygen comment block, with its gallery.
+ * @param group The group to format
+ * @return The comment block, without a trailing newline.
+ */
+
+FString reporter::formatGroup(reportGroupData const& group, galleryAtlas const* atlas)
+{
 	FString tmpl(R"LONGRAW(/**
 	\defgroup {0} {1}
 	\brief {2}
@@ -183,13 +293,19 @@ void reporter::reportGroup(FString groupName, FString groupNamePretty, FString b
 
 	FString gallery = "";
 
-	if (GalleryList.Num())
+	if (group.gallery.Num())
 	{
 		FString galleryItems;
 
-		GalleryList.Sort();		//alphabetize the gallery
-		for (FString e : GalleryList)
-		{	galleryItems += "	" + e + "\n";	}
+		if (atlas)
+			galleryItems = atlas->formatItems();		//sorted the same way
+		else
+		{
+			TArray<FString> list = group.gallery;
+			list.Sort();		//alphabetize the gallery
+			for (FString e : list)
+			{	galleryItems += "	" + e + "\n";	}
+		}
 
 		FString gtmpl(R"LONGRAW(
 	<h2 class='groupheader'>Gallery</h2>
@@ -199,21 +315,8 @@ void reporter::reportGroup(FString groupName, FString groupNamePretty, FString b
 
 		gallery = FString::Format(*gtmpl, { galleryItems });
 	}
-	GalleryList.Empty();		//reset the gallery
-
-	FString groupdata = FString::Format(*tmpl, { groupName, groupNamePretty, brief, details, gallery });
-
-	FString path = outputDir + "/" + groups;
-	FPaths::MakePlatformFilename(path);
-	if (!openFile(path,true))
-	{
-		UE_LOG(LOG_DOT, Error, TEXT("Could not open '%s' for writing."), *path);
-		return;
-	}
-
-	*out << *groupdata << endl;
 
-	closeFile();
+	return FString::Format(*tmpl, { group.name, group.namePretty, group.brief, group.details, gallery });
 }
 
 FString reporter::getGraphCPP(UEdGraph* graph, FString _namespace)
@@ -257,30 +360,14 @@ FString reporter::getGraphCPP(UEdGraph* graph, FString _namespace)
 
 bool reporter::shouldReportAsset(FAssetData const& Asset)
 {
-	//FString path = Asset.GetPackage
+	TStringBuilder<256> path;
 #if ENGINE_MAJOR_VERSION >= 5
-	FString path = Asset.GetObjectPathString();
+	Asset.AppendObjectPath(path);
 #else
-	FString path = Asset.ObjectPath.ToString();
+	Asset.ObjectPath.AppendString(path);
 #endif
 
-
-
-	//wcout << "Checking " << *path << endl;
-
-	for (const FString& IgnoreFolder : IgnoreFolders)
-	{
-		if (path.StartsWith(IgnoreFolder))
-			return false;
-	}
-
-	for (const FString& IncludeFolder : IncludeFolders)
-	{
-		if (path.StartsWith(IncludeFolder))
-			return true;
-	}
-
-	return false;
+	return Folders.matches(path.ToView());
 }
 
 /**
@@ -292,6 +379,9 @@ bool reporter::shouldReportAsset(FAssetData const& Asset)
  *
  * Perhaps in a future version, include will trump ignore, but not for now.
  * This would imply that someone could include "/Game".
+ *
+ * This is called for nodes in every graph, so the path is built on the
+ * stack and matched against the compiled folders.
  */
 
 bool reporter::shouldReportObject(UObject* object)
@@ -299,27 +389,32 @@ bool reporter::shouldReportObject(UObject* object)
 	if (!object)
 		return false;
 
-	FString path = object->GetPathName();
-	//wcout << "SRO path: " << *path << endl;
+	TStringBuilder<256> path;
+	object->GetPathName(nullptr, path);
+
+	return Folders.matches(path.ToView());
+}
+
+/**
+ * @brief Compile IgnoreFolders and IncludeFolders for matching.
+ *
+ * Call this whenever either list changes.  See folderTrie for the rules.
+ */
+
+void reporter::compileFolders()
+{
+	Folders.reset();
 
 	for (const FString& IgnoreFolder : IgnoreFolders)
-	{
-		if (path.StartsWith(IgnoreFolder))
-			return false;
-	}
+		Folders.add(IgnoreFolder, true);
 
 	for (const FString& IncludeFolder : IncludeFolders)
-	{
-		if (path.StartsWith(IncludeFolder))
-			return true;
-	}
-
-	return false;
+		Folders.add(IncludeFolder, false);
 }
 
 void reporter::reportGraph(FString prefix, UEdGraph* g)
 {
-	pinConnections.Empty();		//clear out all connections for each new graph
+	Graph = graphIR();		//clear out all connections for each new graph
 
 	FString graphName;
 	g->GetName(graphName);
@@ -423,22 +518,33 @@ void reporter::reportNode(FString prefix, UEdGraphNode* n)
 }
 
 
-void reporter::writeGraphHeader(FString prefix, UEdGraph* graph, FString qualifier)
+/**
+ * @brief Write a graph from its graphIR: its header, nodes, connections and footer.
+ */
+
+void reporter::renderGraph(FString prefix, graphIR const& graph)
 {
-	FString graphName = graph->GetName();
-	FString graphNameVariable = createVariableName(graphName);
-	FString graphNameHuman = FName::NameToDisplayString(graphName, false);
+	writeGraphHeader(prefix, graph);
 
-	FString brief = GraphDescriptions.FindOrAdd(graph, "");
-	FString details = "";
-	FString details2 = FBlueprintEditorUtils::GetGraphDescription(graph).ToString();
-	if (details2 != "(None)")	//EventGraph never has any description and reports "(None)".
-		details += details2;
+	for (const graphNode& n : graph.nodes)
+		writeNodeBody(prefix + _tab, graph, n);
+
+	writeGraphConnections(prefix, graph);
+	writeGraphFooter(prefix, graph);
+}
+
+void reporter::writeGraphHeader(FString prefix, graphIR const& graph)
+{
+	FString graphNameVariable = createVariableName(graph.name);
+	FString graphNameHuman = FName::NameToDisplayString(graph.name, false);
+
+	FString brief = graph.brief;
+	FString details = graph.details;
 	if (brief == details)		//don't let it repeat.
 		details = "";
 
 	*out << *prefix << "/**" << endl;
-	*out << *prefix << *_tab << "\\qualifier " << *qualifier << endl;
+	*out << *prefix << *_tab << "\\qualifier " << *graph.qualifier << endl;
 	//*out << *prefix << *_tab << "\\private" << endl;
 	if (!brief.IsEmpty())
 		*out << *prefix << *_tab << "\\brief " << *brief << endl;
@@ -446,7 +552,7 @@ void reporter::writeGraphHeader(FString prefix, UEdGraph* graph, FString qualifi
 		*out << *prefix << *_tab << "\\details " << *details << endl;
 	*out << *prefix << *_tab << "\\dot " << *graphNameHuman << endl;
 	*out << *prefix << *_tab << "graph " << *graphNameVariable << " {";
-	*out << *prepTemplateString(prefix + _tab + _tab, NodeStyle, R"LONGRAW(
+	static const compiledTemplate graphTemplate(R"LONGRAW(
 graph [
 	layout="fdp"
 	overlap="true"
@@ -481,14 +587,13 @@ node [
 	fixedsize="shape"
 	color="_BORDERCOLOR_"
 ];)LONGRAW");
+	*out << *renderTemplate(prefix + _tab + _tab, graphTemplate, NodeStyle);
 	*out << endl;
 }
 
-void reporter::writeGraphFooter(FString prefix, UEdGraph *graph)
+void reporter::writeGraphFooter(FString prefix, graphIR const& graph)
 {
-	FString graphName = graph->GetName();
-	FString graphNameVariable = createVariableName(graphName);
-	FString graphNameHuman = FName::NameToDisplayString(graphName, false);
+	FString graphNameHuman = FName::NameToDisplayString(graph.name, false);
 
 	//FString type = g->GetClass()->GetSuperClass()->GetFName().ToString();
 	//FString type = getClassName(graph->GetOuter()->GetClass());
@@ -503,18 +608,39 @@ void reporter::writeGraphFooter(FString prefix, UEdGraph *graph)
 	//	*out << *prefix << *type << " " << *functionName << "(" << *functionArguments << ");" << endl;
 	//else
 
-	FString cpp = getGraphCPP(graph);
-	*out << *prefix << *cpp << ";	//\"" << *graphNameHuman << "\"" << endl;
+	*out << *prefix << *graph.cpp << ";	//\"" << *graphNameHuman << "\"" << endl;
 }
 
-void reporter::writeGraphConnections(FString prefix)
+void reporter::writeGraphConnections(FString prefix, graphIR const& graph)
 {
 	*out << endl;
 
-	for (const TPair<FString, FString>& c : pinConnections)
+	//the pin's node, and whether it is a route, whose connections meet in the middle
+	auto owner = [&graph](const graphPin& p, bool& isRoute) -> FString const&
 	{
+		if (p.node == INDEX_NONE)
+		{
+			isRoute = p.ownerIsRoute;
+			return p.owner;
+		}
+
+		isRoute = graph.nodes[p.node].type == NodeType::route;
+		return graph.nodes[p.node].name;
+	};
+
+	for (const graphEdge& e : graph.edges)
+	{
+		const graphPin& s = graph.pins[e.source];
+		const graphPin& d = graph.pins[e.dest];
+		bool sRoute, dRoute;
+		FString const& sname = owner(s, sRoute);
+		FString const& dname = owner(d, dRoute);
+
 		//FROM:port:_ -- TO:port:_ [ color="colorFmt" ]
-		FString connection = FString::Printf(TEXT("%s [ color=\"%s\" layer=\"edges\" ];"), *c.Key, *c.Value);
+		FString connection = FString::Printf(TEXT("%s:%s:%s -- %s:%s:%s [ color=\"%s\" layer=\"edges\" ];"),
+			*sname, *s.port, sRoute ? TEXT("c") : TEXT("e"),
+			*dname, *d.port, dRoute ? TEXT("c") : TEXT("w"),
+			*graph.pins[e.colorPin].color);
 
 		*out << *prefix << *_tab << *_tab << *connection << endl;
 	}
@@ -530,237 +656,160 @@ bool reporter::urlCheck2(FString &blueprintClassName, FString &variableName, UEd
 	return false;
 }
 
-FString reporter::prepNodePortRows(FString prefix, UEdGraphNode* node, TMap<FString, FString> visiblePins)
+FString reporter::prepNodePortRows(FString prefix, graphIR const& graph, graphNode const& node)
 {
 	//both
-	FString nodeTemplate_11 = R"LONGRAW(<tr>
+	static const compiledTemplate nodeTemplate_11(R"LONGRAW(<tr>
 	<td colspan="2" align="left"  balign="left"  href="_PINURL_" title="_INTOOLTIP_"  port="_INPORT_"><font point-size="_FONTSIZEPORT_" color="_INCOLOR_">_INICON_</font> <font point-size="_FONTSIZEPORT_" color="_FONTCOLOR_">_INLABEL_</font>_HEIGHTSPACER__INVALUE_</td>
 	<td colspan="2" align="right" balign="right" href="_PINURL_" title="_OUTTOOLTIP_" port="_OUTPORT_">_OUTVALUE__HEIGHTSPACER_<font point-size="_FONTSIZEPORT_" color="_FONTCOLOR_">_OUTLABEL_</font> <font point-size="_FONTSIZEPORT_" color="_OUTCOLOR_">_OUTICON_</font></td>
-</tr>)LONGRAW";
+</tr>)LONGRAW");
 
 	//left
-	FString nodeTemplate_10 = R"LONGRAW(<tr>
+	static const compiledTemplate nodeTemplate_10(R"LONGRAW(<tr>
 	<td colspan="2" align="left" balign="left" href="_PINURL_" title="_INTOOLTIP_"  port="_INPORT_"><font point-size="_FONTSIZEPORT_" color="_INCOLOR_">_INICON_</font> <font point-size="_FONTSIZEPORT_" color="_FONTCOLOR_">_INLABEL_</font>_HEIGHTSPACER__INVALUE_</td>
 	<td colspan="2"></td>
-</tr>)LONGRAW";
+</tr>)LONGRAW");
 
-	FString nodeTemplate_01 = R"LONGRAW(<tr>
+	static const compiledTemplate nodeTemplate_01(R"LONGRAW(<tr>
 	<td colspan="2"></td>
 	<td colspan="2" align="right" balign="right" href="_PINURL_" title="_OUTTOOLTIP_" port="_OUTPORT_">_OUTVALUE__HEIGHTSPACER_<font point-size="_FONTSIZEPORT_" color="_FONTCOLOR_">_OUTLABEL_</font> <font point-size="_FONTSIZEPORT_" color="_OUTCOLOR_">_OUTICON_</font></td>
-</tr>)LONGRAW";
+</tr>)LONGRAW");
 
 	//&reg;
 	//&#10122;
-	FString routeTemplate = R"LONGRAW(<tr>
+	static const compiledTemplate routeTemplate(R"LONGRAW(<tr>
 	<td port="port" href="_PINURL_" title="_NODECOMMENT_"><font color="_PINCOLOR_">&#9673;</font></td>
-</tr>)LONGRAW";
+</tr>)LONGRAW");
 
 	//min size 80
-	FString variableTemplate = R"LONGRAW(<tr>
+	static const compiledTemplate variableTemplate(R"LONGRAW(<tr>
 	<td colspan="2"></td>
 	<td colspan="2" width="80" align="right" balign="right" href="_PINURL_" title="_OUTTOOLTIP_" port="_OUTPORT_">_OUTVALUE__HEIGHTSPACER_<font point-size="_FONTSIZEPORT_" color="_FONTCOLOR_">_OUTLABEL_</font> <font point-size="_FONTSIZEPORT_" color="_OUTCOLOR_">_OUTICON_</font></td>
-</tr>)LONGRAW";
+</tr>)LONGRAW");
 
 	//min size 80
-	FString variableTemplate2 = R"LONGRAW(<tr>
+	static const compiledTemplate variableTemplate2(R"LONGRAW(<tr>
 	<td colspan="2" width="40" align="left"  balign="left"  href="_PINURL_" title="_INTOOLTIP_"  port="_INPORT_"><font point-size="_FONTSIZEPORT_" color="_INCOLOR_">_INICON_</font> <font point-size="_FONTSIZEPORT_" color="_FONTCOLOR_">_INLABEL_</font>_HEIGHTSPACER__INVALUE_</td>
 	<td colspan="2" width="40" align="right" balign="right" href="_PINURL_" title="_OUTTOOLTIP_" port="_OUTPORT_">_OUTVALUE__HEIGHTSPACER_<font point-size="_FONTSIZEPORT_" color="_FONTCOLOR_">_OUTLABEL_</font> <font point-size="_FONTSIZEPORT_" color="_OUTCOLOR_">_OUTICON_</font></td>
-</tr>)LONGRAW";
+</tr>)LONGRAW");
 
-	FString variablesetTemplate = R"LONGRAW(<tr>
+	static const compiledTemplate variablesetTemplate(R"LONGRAW(<tr>
 	<td colspan="2" align="left"  balign="left"  href="_PINURL_" title="_INTOOLTIP_"  port="_INPORT_"><font point-size="_FONTSIZEPORT_" color="_INCOLOR_">_INICON_</font> <font point-size="_FONTSIZEPORT_" color="_FONTCOLOR_">_INLABEL_</font>_HEIGHTSPACER__INVALUE_</td>
 	<td colspan="2" align="right" balign="right" href="_PINURL_" title="_OUTTOOLTIP_" port="_OUTPORT_">_HEIGHTSPACER_<font point-size="_FONTSIZEPORT_" color="_OUTCOLOR_">_OUTICON_</font></td>
-</tr>)LONGRAW";
+</tr>)LONGRAW");
 
-	bool isRoute = getNodeType(node, NodeType::node) == NodeType::route;
-	bool isVariable = getNodeType(node, NodeType::node) == NodeType::variable;
-	bool isVariableset = getNodeType(node, NodeType::node) == NodeType::variableset;
-	bool isCompact = getNodeType(node, NodeType::node) == NodeType::compact;
-	bool isConnected = false;		//changed below
-	bool otherIsRoute = false;		//updated below
+	NodeType type = node.type;
+	bool isRoute = type == NodeType::route;
+	bool isVariable = type == NodeType::variable;
+	bool isVariableset = type == NodeType::variableset;
+	bool isCompact = type == NodeType::compact;
 
 	FString rows;
 
-	vmap pindata;
-	pindata.Add("_PINCOLOR_", "_PINDEFAULTCOLOR_");
-
-	pindata.Add("_INPORT_", "");
-	pindata.Add("_INICON_", "&nbsp;");
-	pindata.Add("_INLABEL_", "&nbsp;");
-	pindata.Add("_INCOLOR_", "_PINDEFAULTCOLOR_");
-	pindata.Add("_INVALUE_", "");
-	pindata.Add("_INTOOLTIP_", "");
-
-	pindata.Add("_OUTPORT_", "");
-	pindata.Add("_OUTICON_", "&nbsp;");
-	pindata.Add("_OUTLABEL_", "&nbsp;");
-	pindata.Add("_OUTCOLOR_", "_PINDEFAULTCOLOR_");
-	pindata.Add("_OUTVALUE_", "");			// ...probably never used
-	pindata.Add("_OUTTOOLTIP_", "");
-
-	bool NeedsAddPin = false;
-	IK2Node_AddPinInterface* n = Cast<IK2Node_AddPinInterface>(node);
-	if (n && n->CanAddPin())
-	{
-		//add add pin on output, which is purely cosmetic.
-		NeedsAddPin = true;
-		//n->AddInputPin();		//not what we want... will add to the left with no control
-	}
-
-	const TArray< UEdGraphPin* > pins = node->Pins;
-	//const TArray< UEdGraphPin* > pins = n->GetAllPins();
-
-	TArray< UEdGraphPin* > ins;
-	TArray< UEdGraphPin* > outs;
-	for (UEdGraphPin* p : pins)
-	{
-		//don't show hidden pins
-		if (!pinShouldBeVisible(p,visiblePins))
-			continue;
-
-		if (p->Direction == EEdGraphPinDirection::EGPD_Input)
-			ins.Add(p);
-		else
-			if (!isDelegatePin(p))
-				outs.Add(p);
-	}
-
-	TMap<FString, FString> vp;
-	FString sname, sport, sside, dname, dport, dside, color, connection;
-	FString rowTemplate;
-	UEdGraphPin *i=NULL, *o=NULL;
+	styleSlots pindata(&NodeStyle);
+	pindata.set(StyleKey::PINCOLOR, "_PINDEFAULTCOLOR_");
+
+	pindata.set(StyleKey::INPORT, "");
+	pindata.set(StyleKey::INICON, "&nbsp;");
+	pindata.set(StyleKey::INLABEL, "&nbsp;");
+	pindata.set(StyleKey::INCOLOR, "_PINDEFAULTCOLOR_");
+	pindata.set(StyleKey::INVALUE, "");
+	pindata.set(StyleKey::INTOOLTIP, "");
+
+	pindata.set(StyleKey::OUTPORT, "");
+	pindata.set(StyleKey::OUTICON, "&nbsp;");
+	pindata.set(StyleKey::OUTLABEL, "&nbsp;");
+	pindata.set(StyleKey::OUTCOLOR, "_PINDEFAULTCOLOR_");
+	pindata.set(StyleKey::OUTVALUE, "");			// ...probably never used
+	pindata.set(StyleKey::OUTTOOLTIP, "");
+
+	//add add pin on output, which is purely cosmetic.
+	bool NeedsAddPin = node.canAddPin;
+
+	//the visible pins, hidden ones already left out
+	FString color;
+	const compiledTemplate* rowTemplate = NULL;
+	const graphPin *i=NULL, *o=NULL;
 	int c = 0;
-	while (ins.Num() > 0 || outs.Num() > 0)
+	while (c < node.inputs.Num() || c < node.outputs.Num())
 	{
-		if (ins.Num())
-		{
-			i = ins[0];
-			ins.RemoveAt(0);
-		}
-		else
-			i = NULL;
-
-		if (outs.Num())
-		{
-			o = outs[0];
-			outs.RemoveAt(0);
-		}
-		else
-			o = NULL;
+		i = c < node.inputs.Num() ? &graph.pins[node.inputs[c]] : NULL;
+		o = c < node.outputs.Num() ? &graph.pins[node.outputs[c]] : NULL;
 
 		if (isRoute)
-			rowTemplate = routeTemplate;
+			rowTemplate = &routeTemplate;
 		else if (isVariable)
-			rowTemplate = i ? variableTemplate2 : variableTemplate;
+			rowTemplate = i ? &variableTemplate2 : &variableTemplate;
 		else if (isVariableset)
-			rowTemplate = variablesetTemplate;
+			rowTemplate = &variablesetTemplate;
 		else if (i && (o || NeedsAddPin))
-			rowTemplate = nodeTemplate_11;
+			rowTemplate = &nodeTemplate_11;
 		else if (i && !o)
-			rowTemplate = nodeTemplate_10;
+			rowTemplate = &nodeTemplate_10;
 		else if (!i && (o || NeedsAddPin))
-			rowTemplate = nodeTemplate_01;
+			rowTemplate = &nodeTemplate_01;
 		else
 			UE_LOG(LOG_DOT, Error, TEXT("No row in or out.. this should never happen."));
 
 		if (i)
 		{
-			dport = getPinPort(i);
-			color = getPinColor(i);
-			isConnected = i->HasAnyConnections();
-
-			pindata["_PINCOLOR_"] = color;
-			pindata["_INPORT_"] = dport;
-			pindata["_INICON_"] = getPinIcon(i);
-			pindata["_INLABEL_"] = isCompact ? "" : getPinLabel(i);
-			pindata["_INCOLOR_"] = color;
-			pindata["_INVALUE_"] = isConnected ? "" : getPinDefaultValue(i);
-			pindata["_INTOOLTIP_"] = getPinTooltip(i,visiblePins);
-
-			//create connection(s)
-			dname = i->GetOwningNode()->GetName();		//the source name, from this output
-			for (UEdGraphPin* s : i->LinkedTo)
-			{
-				vp = getVisiblePins(s->GetOwningNode());
-				if (!pinShouldBeVisible(s, vp))
-					continue;
-
-				otherIsRoute = getNodeType(s->GetOwningNode(), NodeType::node) == NodeType::route;
-				sname = s->GetOwningNode()->GetName();	//the destination node, from this output
-				sport = getPinPort(s);
-
-				sside = otherIsRoute	? "c" : "e";
-				dside = isRoute			? "c" : "w";
-
-				connection = FString::Printf(TEXT("%s:%s:%s -- %s:%s:%s"), *sname, *sport, *sside, *dname, *dport, *dside);
-				pinConnections.Add(connection, color);
-			}
+			color = i->color;
+
+			pindata.set(StyleKey::PINCOLOR, color);
+			pindata.set(StyleKey::INPORT, i->port);
+			pindata.set(StyleKey::INICON, i->icon);
+			pindata.set(StyleKey::INLABEL, isCompact ? "" : i->label);
+			pindata.set(StyleKey::INCOLOR, color);
+			pindata.set(StyleKey::INVALUE, i->value);
+			pindata.set(StyleKey::INTOOLTIP, i->tooltip);
 		}
 		else
 		{
-			pindata["_INPORT_"] = "";
-			pindata["_INICON_"] = "&nbsp;";
-			pindata["_INLABEL_"] = "&nbsp;";
-			pindata["_INCOLOR_"] = "_PINDEFAULTCOLOR_";
-			pindata["_INVALUE_"] = "";
-			pindata["_INTOOLTIP_"] = "";
+			pindata.set(StyleKey::INPORT, "");
+			pindata.set(StyleKey::INICON, "&nbsp;");
+			pindata.set(StyleKey::INLABEL, "&nbsp;");
+			pindata.set(StyleKey::INCOLOR, "_PINDEFAULTCOLOR_");
+			pindata.set(StyleKey::INVALUE, "");
+			pindata.set(StyleKey::INTOOLTIP, "");
 		}
 
 		if (o)
 		{
-			sport = getPinPort(o);
-			color = getPinColor(o);
-			isConnected = o->HasAnyConnections();
-
-			pindata["_PINCOLOR_"] = color;
-			pindata["_OUTPORT_"] = sport;
-			pindata["_OUTICON_"] = getPinIcon(o);
-			pindata["_OUTLABEL_"] = isCompact ? "" : getPinLabel(o);
-			pindata["_OUTCOLOR_"] = color;
-			pindata["_OUTVALUE_"] = isConnected ? "" : getPinDefaultValue(o);	//ever used?
-			pindata["_OUTTOOLTIP_"] = getPinTooltip(o);
-
-			//create connection(s)
-			sname = o->GetOwningNode()->GetName();		//the source name, from this output
-			for (UEdGraphPin* d : o->LinkedTo)
-			{
-				vp = getVisiblePins(d->GetOwningNode());
-				if (!pinShouldBeVisible(d, vp))
-					continue;
-
-				otherIsRoute = getNodeType(d->GetOwningNode(), NodeType::node) == NodeType::route;
-				dname = d->GetOwningNode()->GetName();	//the destination node, from this output
-				dport = getPinPort(d);
-
-				sside = isRoute			? "c" : "e";
-				dside = otherIsRoute	? "c" : "w";
-
-				connection = FString::Printf(TEXT("%s:%s:%s -- %s:%s:%s"), *sname, *sport, *sside, *dname, *dport, *dside);
-				pinConnections.Add(connection, color);
-			}
+			color = o->color;
+
+			pindata.set(StyleKey::PINCOLOR, color);
+			pindata.set(StyleKey::OUTPORT, o->port);
+			pindata.set(StyleKey::OUTICON, o->icon);
+			pindata.set(StyleKey::OUTLABEL, isCompact ? "" : o->label);
+			pindata.set(StyleKey::OUTCOLOR, color);
+			pindata.set(StyleKey::OUTVALUE, o->value);	//ever used?
+			pindata.set(StyleKey::OUTTOOLTIP, o->tooltip);
 		}
 		else if (NeedsAddPin)
 		{
-			pindata["_OUTPORT_"] = "";
-			pindata["_OUTICON_"] = PinIcons["addpin"].Key;
-			pindata["_OUTLABEL_"] = "<font color=\"_VALCOLOR_\">Add pin</font>";
-			pindata["_OUTCOLOR_"] = "_BORDERCOLOR_";
-			pindata["_OUTVALUE_"] = "";
-			pindata["_OUTTOOLTIP_"] = "";
+			pindata.set(StyleKey::OUTPORT, "");
+			pindata.set(StyleKey::OUTICON, PinIcons["addpin"].Key);
+			pindata.set(StyleKey::OUTLABEL, "<font color=\"_VALCOLOR_\">Add pin</font>");
+			pindata.set(StyleKey::OUTCOLOR, "_BORDERCOLOR_");
+			pindata.set(StyleKey::OUTVALUE, "");
+			pindata.set(StyleKey::OUTTOOLTIP, "");
 
 			NeedsAddPin = false;
 		}
 		else
 		{
-			pindata["_OUTPORT_"] = "";
-			pindata["_OUTICON_"] = "&nbsp;";
-			pindata["_OUTLABEL_"] = "&nbsp;";
-			pindata["_OUTCOLOR_"] = "_PINDEFAULTCOLOR_";
-			pindata["_OUTVALUE_"] = "";
-			pindata["_OUTTOOLTIP_"] = "";
+			pindata.set(StyleKey::OUTPORT, "");
+			pindata.set(StyleKey::OUTICON, "&nbsp;");
+			pindata.set(StyleKey::OUTLABEL, "&nbsp;");
+			pindata.set(StyleKey::OUTCOLOR, "_PINDEFAULTCOLOR_");
+			pindata.set(StyleKey::OUTVALUE, "");
+			pindata.set(StyleKey::OUTTOOLTIP, "");
 		}
 
-		rows += prepTemplateString("", pindata, rowTemplate)+"\n";
+		//the pin data and the node style are filled in one pass
+		if (rowTemplate)
+			rows += renderTemplate("", *rowTemplate, pindata);
+		rows += "\n";
 
 		c++;
 	}
@@ -772,7 +821,7 @@ FString reporter::prepNodePortRows(FString prefix, UEdGraphNode* node, TMap<FStr
 
 	rows.TrimEndInline();
 
-	rows = prepTemplateString(prefix, NodeStyle, rows);
+	rows = indentTemplateString(prefix, prefix + rows);
 
 	return rows;
 }
@@ -914,7 +963,8 @@ FString reporter::getNodeURL(UEdGraphNode* node, EEdGraphPinDirection direction)
 	//macro								X
 	//material nodes?
 
-	NodeType type = getNodeType(node, NodeType::node);
+	const int32* index = NodeIndex.Find(node);
+	NodeType type = index ? Graph.nodes[*index].type : getNodeType(node, NodeType::node);
 	FString url = "";
 
 	UBlueprint* blueprint = FBlueprintEditorUtils::FindBlueprintForNode(node);
@@ -1175,82 +1225,317 @@ FString reporter::getNodeURL(UEdGraphNode* node, EEdGraphPinDirection direction)
 	return url;
 }
 
-void reporter::writeNodeBody(FString prefix, UEdGraphNode* n)
+/**
+ * @brief Copy a graph into Graph, ready for renderGraph().
+ * @param g The graph
+ * @param qualifier Its doxygen qualifier, eg: "Blueprint"
+ *
+ * This is the only part of writing a graph that reads the UObjects, so it
+ * has to run on the game thread.  Any descriptions of this graph, found on
+ * the node that collapsed it, should be in GraphDescriptions by now.
+ */
+
+void reporter::extractGraph(UEdGraph* g, FString qualifier)
 {
-	//should we be casting to UK2Node instead of using UEdGraphNode?
+	Graph = graphIR();
 
-	FString nodename = n->GetName();
+	Graph.name = g->GetName();
+	Graph.qualifier = qualifier;
+	Graph.brief = GraphDescriptions.FindOrAdd(g, "");
 
-	NodeType type = getNodeType(n, NodeType::node);
-	FString typeGroup = getNodeTypeGroup(type);
-	FString url = getNodeURL(n);
-	FString tooltip = getNodeTooltip(n);
+	FString details = FBlueprintEditorUtils::GetGraphDescription(g).ToString();
+	if (details != "(None)")	//EventGraph never has any description and reports "(None)".
+		Graph.details = details;
 
-	FString title,title2;
-	title = getNodeTitle(n,title2);
+	Graph.cpp = getGraphCPP(g);
 
-	bool hasBubble = getNodeHasBubble(n);
+	extractNodes(g);
+	extractPins(g);		//all of the graph's connections, from the nodes
+}
 
-	UEdGraphNode_Comment* commentNode = dynamic_cast<UEdGraphNode_Comment*>(n);
-	FLinearColor titleColor = (commentNode) ? commentNode->CommentColor : n->GetNodeTitleColor();
+/**
+ * @brief Copy every node in a graph into Graph.nodes, in one pass.
+ * @param g The graph
+ */
+
+void reporter::extractNodes(UEdGraph* g)
+{
+	NodeIndex.Reset();
+
+	Graph.nodes.Reserve(g->Nodes.Num());
+	NodeIndex.Reserve(g->Nodes.Num());
+
+	int32 first = Graph.nodes.Num();
+	for (UEdGraphNode* n : g->Nodes)
+		extractNode(n);
+
+	//the graph's header colors, converted together.  The dim and text colors have the
+	//same alpha and gamma as the plain header color, so they go in its batch.
+	int32 num = g->Nodes.Num();
+	TArray<FLinearColor> titleColors, plainColors;
+	titleColors.Reserve(num);
+	for (UEdGraphNode* n : g->Nodes)
+		titleColors.Add(getNodeTitleColor(n));
+
+	plainColors.Reserve(num * 3);
+	plainColors.Append(titleColors);
+	for (const FLinearColor& c : titleColors)
+		plainColors.Add(c * 0.5f);
+	for (const FLinearColor& c : titleColors)
+		plainColors.Add(c.LinearRGBToHSV().B < .6f ? FLinearColor::White : FLinearColor::Black);
+
+	TArray<FString> plain, light, trans;
+	createColorStrings(plainColors, plain);
+	createColorStrings(titleColors, light, 1.0f, 3.0f);
+	createColorStrings(titleColors, trans, 0.5f);
+
+	for (int32 i = 0; i < num; i++)
+	{
+		graphNode& n = Graph.nodes[first + i];
+		n.headerColor = plain[i];
+		n.headerColorDim = plain[num + i];
+		n.headerColorLight = light[i];
+		n.headerColorTrans = trans[i];
+		n.headerTextColor = plain[num * 2 + i];
+	}
+}
+
+FLinearColor reporter::getNodeTitleColor(UEdGraphNode* node)
+{
+	UEdGraphNode_Comment* commentNode = dynamic_cast<UEdGraphNode_Comment*>(node);
+	return (commentNode) ? commentNode->CommentColor : node->GetNodeTitleColor();
+}
+
+/**
+ * @brief Copy a node into Graph.nodes.
+ * @param node The node
+ * @return The copy, valid until the next node is added.
+ *
+ * Its header colors are filled in afterwards, for the whole graph at once,
+ * by extractNodes().
+ */
 
-	FLinearColor titleTextColor = FLinearColor::Black;
-	if (titleColor.LinearRGBToHSV().B < .6f)
-		titleTextColor = FLinearColor::White;
+graphNode& reporter::extractNode(UEdGraphNode* node)
+{
+	NodeIndex.Add(node, Graph.nodes.Num());
+	graphNode& n = Graph.nodes.AddDefaulted_GetRef();
+
+	n.name = node->GetName();
+	n.guid = node->NodeGuid.ToString();
+	n.type = getNodeType(node, NodeType::node);
+	n.typeGroup = getNodeTypeGroup(n.type);
+	n.title = getNodeTitle(node, n.title2);
+	n.tooltip = getNodeTooltip(node);
+	n.hasBubble = getNodeHasBubble(node);
+	n.visiblePins = getVisiblePins(node);
+	n.delegateIcon = getDelegateIcon(node, &n.hasDelegate);		//TODO: add node delegate tooltip
+
+	if (n.type == NodeType::compact)
+	{
+		UK2Node* n2 = dynamic_cast<UK2Node*>(node);
+		if (n2 && n2->ShouldDrawCompact())
+		{
+			n.compactTitle = n2->GetCompactNodeTitle().ToString();
+			n.hasCompactTitle = true;
+		}
+	}
+
+	n.comment = node->NodeComment;						// if (mn)	comment_ = mn->MaterialExpression->Desc;
 
 #if ENGINE_MAJOR_VERSION >= 5
-	int commentSize = (commentNode) ? commentNode->GetFontSize() : 18;
-#else
-	int commentSize = 18;
+	UEdGraphNode_Comment* commentNode = dynamic_cast<UEdGraphNode_Comment*>(node);
+	n.commentSize = (commentNode) ? commentNode->GetFontSize() : 18;
 #endif
 
-	TMap<FString, FString> visiblePins = getVisiblePins(n);						// if empty, all pins are allowed.  Otherwise only these pins are allowed.  This is set during node reporting.
+	n.posX = node->NodePosX;
+	n.posY = node->NodePosY;
+	n.width = node->NodeWidth;
+	n.height = node->NodeHeight;
 
-	if (type == NodeType::compact)
+	IK2Node_AddPinInterface* addPin = Cast<IK2Node_AddPinInterface>(node);
+	n.canAddPin = addPin && addPin->CanAddPin();
+	//n->AddInputPin();		//not what we want... will add to the left with no control
+
+	//last, since getNodeURL() reads the type back from here
+	n.url = getNodeURL(node);
+
+	return n;
+}
+
+/**
+ * @brief Copy a graph's visible pins into Graph.pins, and find its connections, in one pass.
+ * @param g The graph, after extractNodes()
+ *
+ * Each node's rows are its visible inputs, and its visible outputs that
+ * aren't delegates, in pin order.  Each connection is kept once, as a pair
+ * of pin indices, in the order the rows find them: row by row, the input's
+ * links and then the output's.  It's found again from its other end, which
+ * only changes its color to that end's pin.
+ *
+ * A link to a visible pin on a node outside the graph's node list is kept,
+ * as it always was; that pin is added to Graph.pins without a row.
+ */
+
+void reporter::extractPins(UEdGraph* g)
+{
+	PinIndex.Reset();
+
+	TArray<UEdGraphPin*> pins;		//the same as Graph.pins, while we still need the links
+	for (UEdGraphNode* n : g->Nodes)
 	{
-		int titleLen = title.Len();		//before compact is htmlentities-ed
+		int32 node = NodeIndex.FindChecked(n);
+		graphNode& gn = Graph.nodes[node];
+		bool isRoute = gn.type == NodeType::route;
 
-		UK2Node* n2 = dynamic_cast<UK2Node*>(n);
-		if (n2)
+		for (UEdGraphPin* p : n->Pins)
 		{
-			//titleColor = n2->GetNodeTitleColor();
-			//GetPinHoverText
+			//don't show hidden pins
+			if (!pinShouldBeVisible(p, gn.visiblePins))
+				continue;
+
+			int32 index = Graph.pins.Num();
+			PinIndex.Add(p, index);
+			pins.Add(p);
+
+			graphPin& gp = Graph.pins.AddDefaulted_GetRef();
+			gp.node = node;
+			gp.port = getPinPort(p, isRoute);
+			gp.color = getPinColor(p);
+
+			bool isInput = p->Direction == EEdGraphPinDirection::EGPD_Input;
+			if (!isInput && isDelegatePin(p))
+				continue;		//no row
 
-			if (n2->ShouldDrawCompact())
+			(isInput ? gn.inputs : gn.outputs).Add(index);
+
+			gp.icon = getPinIcon(p);
+			gp.label = getPinLabel(p);
+			gp.value = p->HasAnyConnections() ? "" : getPinDefaultValue(p);
+			gp.tooltip = isInput ? getPinTooltip(p, gn.visiblePins) : getPinTooltip(p);
+		}
+	}
+
+	TMap<UEdGraphPin*, int32> outside;	//pins on nodes outside g->Nodes, that links reach
+
+	auto findPin = [&](UEdGraphPin* p) -> int32
+	{
+		if (const int32* index = PinIndex.Find(p))
+			return *index;
+
+		UEdGraphNode* owner = p->GetOwningNode();
+		if (NodeIndex.Contains(owner))
+			return INDEX_NONE;		//hidden
+		if (const int32* index = outside.Find(p))
+			return *index;
+		if (!pinShouldBeVisible(p, getVisiblePins(owner)))
+			return INDEX_NONE;
+
+		bool isRoute = getNodeType(owner, NodeType::node) == NodeType::route;
+
+		int32 index = Graph.pins.Num();
+		outside.Add(p, index);
+
+		graphPin& gp = Graph.pins.AddDefaulted_GetRef();
+		gp.owner = owner->GetName();
+		gp.ownerIsRoute = isRoute;
+		gp.port = getPinPort(p, isRoute);
+		gp.color = getPinColor(p);
+
+		return index;
+	};
+
+	TMap<uint64, int32> found;		//source and dest pins, to the edge
+
+	auto addEdge = [&](int32 source, int32 dest, int32 colorPin)
+	{
+		uint64 key = ((uint64)source << 32) | (uint32)dest;
+		if (int32* e = found.Find(key))
+		{
+			Graph.edges[*e].colorPin = colorPin;
+			return;
+		}
+
+		found.Add(key, Graph.edges.Num());
+		Graph.edges.Add({ source, dest, colorPin });
+	};
+
+	for (const graphNode& gn : Graph.nodes)
+	{
+		for (int32 r = 0; r < gn.inputs.Num() || r < gn.outputs.Num(); r++)
+		{
+			if (r < gn.inputs.Num())
+			{
+				int32 i = gn.inputs[r];
+				for (UEdGraphPin* s : pins[i]->LinkedTo)
+				{
+					int32 source = findPin(s);
+					if (source != INDEX_NONE)		//not hidden
+						addEdge(source, i, i);
+				}
+			}
+
+			if (r < gn.outputs.Num())
 			{
-				FString compact = n2->GetCompactNodeTitle().ToString();
-				titleLen = compact.Len();
-				title = htmlentities(compact);				// dot/graphviz doesn't like different char encodings.
+				int32 o = gn.outputs[r];
+				for (UEdGraphPin* d : pins[o]->LinkedTo)
+				{
+					int32 dest = findPin(d);
+					if (dest != INDEX_NONE)
+						addEdge(o, dest, o);
+				}
 			}
 		}
+	}
+}
+
+/**
+ * @brief Write a node, and its comment bubble, from the graphIR.
+ */
+
+void reporter::writeNodeBody(FString prefix, graphIR const& graph, graphNode const& node)
+{
+	NodeType type = node.type;
+
+	FString title = node.title;
+	bool hasBubble = node.hasBubble;
+
+	if (type == NodeType::compact)
+	{
+		int titleLen = title.Len();		//before compact is htmlentities-ed
+
+		if (node.hasCompactTitle)
+		{
+			titleLen = node.compactTitle.Len();
+			title = htmlentities(node.compactTitle);				// dot/graphviz doesn't like different char encodings.
+		}
 
 		//wcout << "COMPACT: " << *title << " - " << titleLen << endl;
 
 		if (titleLen > 2)
 		{
 			int charWidth = 10;
-			//NodeStyle.Add("_COMPACTSIZE_", "17");
-			NodeStyle.Add("_COMPACTSIZE_", "16");
-			NodeStyle.Add("_COMPACTWIDTH_", FString::Printf(TEXT("%d"), 70 + charWidth * titleLen));
+			//NodeStyle.set(StyleKey::COMPACTSIZE, "17");
+			NodeStyle.set(StyleKey::COMPACTSIZE, "16");
+			NodeStyle.set(StyleKey::COMPACTWIDTH, FString::Printf(TEXT("%d"), 70 + charWidth * titleLen));
 		}
 		else
 		{
-			//NodeStyle.Add("_COMPACTSIZE_", "36");
-			NodeStyle.Add("_COMPACTSIZE_", "16");
-			NodeStyle.Add("_COMPACTWIDTH_", "100");
+			//NodeStyle.set(StyleKey::COMPACTSIZE, "36");
+			NodeStyle.set(StyleKey::COMPACTSIZE, "16");
+			NodeStyle.set(StyleKey::COMPACTWIDTH, "100");
 		}
 	}
 
 	if (type == NodeType::variableset)
 	{
-		NodeStyle.Add("_COMPACTSIZE_", "16");
-		NodeStyle.Add("_COMPACTWIDTH_", "90");
+		NodeStyle.set(StyleKey::COMPACTSIZE, "16");
+		NodeStyle.set(StyleKey::COMPACTWIDTH, "90");
 	}
 
-	float posx = (float)n->NodePosX / _dpi;
-	float posy = (float)n->NodePosY / -_dpi;						// y is inverted
-	float width = (float)n->NodeWidth * _scale;
-	float height = (float)n->NodeHeight * _scale;
+	float posx = (float)node.posX / _dpi;
+	float posy = (float)node.posY / -_dpi;						// y is inverted
+	float width = (float)node.width * _scale;
+	float height = (float)node.height * _scale;
 
 	if (type == NodeType::route)
 	{	posx += 14.0f / _dpi;
@@ -1258,7 +1543,7 @@ void reporter::writeNodeBody(FString prefix, UEdGraphNode* n)
 	}
 
 	TArray<FString> lines;													// we throw this away
-	FString comment = n->NodeComment.TrimStartAndEnd();					// if (mn)	comment_ = mn->MaterialExpression->Desc;
+	FString comment = node.comment.TrimStartAndEnd();
 	float numLines = comment.ParseIntoArrayLines(lines, false);			// for bubble
 	//if (numLines == 1)
 	//	comment = comment + "&nbsp;";										//spaces out the bubble
@@ -1270,33 +1555,29 @@ void reporter::writeNodeBody(FString prefix, UEdGraphNode* n)
 
 	//wcout << "FTITLE: " << *title << " ## " << hasBubble << " * " << (mn?1:0) << " ## " << *comment << endl;
 
-	bool hasDelegate = false;
-
-	NodeStyle.Add("_NODENAME_", nodename);
-	NodeStyle.Add("_NODEGUID_", n->NodeGuid.ToString());
-	NodeStyle.Add("_NODEICON_", getNodeIcon(n));
-	NodeStyle.Add("_NODEDELEGATE_", getDelegateIcon(n,&hasDelegate));	//TODO: add node delegate tooltip
-	NodeStyle.Add("_NODETITLE_", title);
-	NodeStyle.Add("_NODETITLE2_", title2);
-	//NodeStyle.Add("_NODECOLOR_", createColorString(n->GetNodeBodyTintColor()));
-	NodeStyle.Add("_NODECOMMENT_", comment);
-	NodeStyle.Add("_POS_", FString::Printf(TEXT("%0.2f,%0.2f!"), posx, posy));
-	NodeStyle.Add("_WIDTH_", FString::Printf(TEXT("%0.2f"), width));
-	NodeStyle.Add("_HEIGHT_", FString::Printf(TEXT("%0.2f"), height));
-	NodeStyle.Add("_TOOLTIP_", tooltip);
-	NodeStyle.Add("_HEADERCOLOR_", createColorString(titleColor));
-	NodeStyle.Add("_HEADERCOLORDIM_", createColorString(titleColor * 0.5f, 1.0f, 1.0f));
-	NodeStyle.Add("_HEADERCOLORLIGHT_", createColorString(titleColor, 1.0f, 3.0f));
-	NodeStyle.Add("_HEADERCOLORTRANS_", createColorString(titleColor, 0.5f));
-	NodeStyle.Add("_HEADERTEXTCOLOR_", createColorString(titleTextColor));
-	NodeStyle.Add("_CLASS_", typeGroup);
-	NodeStyle.Add("_URL_", url);				//URL = "\ref SomeSubgraph"
-	NodeStyle.Add("_PORTROWS_", prepNodePortRows(prefix+_tab+_tab,n,visiblePins));
-	NodeStyle.Add("_FONTSIZECOMMENT_", FString::FromInt(commentSize));
-
-	FString nodeTemplate = getNodeTemplate(type, hasDelegate);
-
-	*out << *prepTemplateString(prefix + _tab, NodeStyle, nodeTemplate) << endl;
+	NodeStyle.set(StyleKey::NODENAME, node.name);
+	NodeStyle.set(StyleKey::NODEGUID, node.guid);
+	NodeStyle.set(StyleKey::NODEICON, getNodeIcon(type));
+	NodeStyle.set(StyleKey::NODEDELEGATE, node.delegateIcon);
+	NodeStyle.set(StyleKey::NODETITLE, title);
+	NodeStyle.set(StyleKey::NODETITLE2, node.title2);
+	//NodeStyle.set(StyleKey::NODECOLOR, createColorString(n->GetNodeBodyTintColor()));
+	NodeStyle.set(StyleKey::NODECOMMENT, comment);
+	NodeStyle.set(StyleKey::POS, FString::Printf(TEXT("%0.2f,%0.2f!"), posx, posy));
+	NodeStyle.set(StyleKey::WIDTH, FString::Printf(TEXT("%0.2f"), width));
+	NodeStyle.set(StyleKey::HEIGHT, FString::Printf(TEXT("%0.2f"), height));
+	NodeStyle.set(StyleKey::TOOLTIP, node.tooltip);
+	NodeStyle.set(StyleKey::HEADERCOLOR, node.headerColor);
+	NodeStyle.set(StyleKey::HEADERCOLORDIM, node.headerColorDim);
+	NodeStyle.set(StyleKey::HEADERCOLORLIGHT, node.headerColorLight);
+	NodeStyle.set(StyleKey::HEADERCOLORTRANS, node.headerColorTrans);
+	NodeStyle.set(StyleKey::HEADERTEXTCOLOR, node.headerTextColor);
+	NodeStyle.set(StyleKey::CLASS, node.typeGroup);
+	NodeStyle.set(StyleKey::URL, node.url);				//URL = "\ref SomeSubgraph"
+	NodeStyle.set(StyleKey::PORTROWS, prepNodePortRows(prefix+_tab+_tab, graph, node));
+	NodeStyle.set(StyleKey::FONTSIZECOMMENT, FString::FromInt(node.commentSize));
+
+	*out << *renderTemplate(prefix + _tab, getCompiledNodeTemplate(type, node.hasDelegate), NodeStyle) << endl;
 
 	//if a comment is visible, add it as a node and connect the arrow
 	if (hasBubble)
@@ -1308,12 +1589,11 @@ void reporter::writeNodeBody(FString prefix, UEdGraphNode* n)
 		float cposx = posx + (type == NodeType::route ? -.226f : 0.0f);	//&#10752;
 		float cposy = posy + ((numLines * lineHeight) + margin) / _dpi;
 
-		NodeStyle.Add("_POS_", FString::Printf(TEXT("%0.2f,%0.2f!"), cposx, cposy));
+		NodeStyle.set(StyleKey::POS, FString::Printf(TEXT("%0.2f,%0.2f!"), cposx, cposy));
 
-		FString commentString = getNodeTemplate(NodeType::bubble);
 		//FString connection = FString::Printf(TEXT("%s %s [ color=\"_NODECOLOR_\" layer=\"edges\" arrowhead=\"normal\" direction=\"forward\" penwidth=\"5\" ];"), *c.Key, *c.Value);
 
-		*out << *prepTemplateString(prefix + _tab, NodeStyle, commentString) << endl;
+		*out << *renderTemplate(prefix + _tab, getCompiledNodeTemplate(NodeType::bubble), NodeStyle) << endl;
 		//*out << *prefix << *_tab << *connection << endl;		//don't need an edge here now because of the arrow/triangle
 	}
 }
@@ -1412,6 +1692,11 @@ bool reporter::createThumbnailFile(UObject* object, FString pngPath)
 
 	//wcout << "FNAME: |" << *fullName << "|" << endl;
 
+	FString cachePath = getThumbnailCachePath(package->GetFName(), fullName);
+	bool hasThumbnail;
+	if (readThumbnailCache(cachePath, pngPath, hasThumbnail))
+		return hasThumbnail;
+
 #if ENGINE_MAJOR_VERSION >= 5
 	FLinkerLoad* Linker = package->GetLinker();	//NO! Won't work.
 #else
@@ -1424,72 +1709,402 @@ bool reporter::createThumbnailFile(UObject* object, FString pngPath)
 		{
 			FThumbnailMap& LinkerThumbnails = Linker->LinkerRoot->AccessThumbnailMap();
 
-			for (TMap<FName, FObjectThumbnail>::TIterator It(LinkerThumbnails); It; ++It)
-			{
-				FName& ObjectFullName = It.Key();
-				FObjectThumbnail& Thumb = It.Value();
+			FObjectThumbnail* Thumb = LinkerThumbnails.Find(FName(*fullName));
+			if (Thumb && Thumb->GetImageWidth() && Thumb->GetImageHeight() && Thumb->GetUncompressedImageData().Num())
+				return writeThumbnail(*Thumb, pngPath, cachePath);
+
+			//UE_LOG(LOG_DOT, Warning, TEXT("Could not find thumbnail: '%s'."), *fullName);
+		}
 
-				int32 w = Thumb.GetImageWidth();
-				int32 h = Thumb.GetImageHeight();
-				int32 s = Thumb.GetUncompressedImageData().Num();
+		writeThumbnailCache(cachePath, TArray<uint8>());	//the package has none for this object
+	}
+	else
+	{
+		//UE_LOG(LOG_DOT, Error, TEXT("No linker: '%s'."), *pngPath);
+	}
 
-				//wcout << "RNAME: |" << *ObjectFullName.ToString() << "| " << w << "x" << h << " @ " << s << " bytes" << endl;
+	return false;
+}
 
-				if ( w && h && s )
-				if (ObjectFullName.ToString() == fullName)
-				{
-					IImageWrapperModule& ImageWrapperModule = FModuleManager::Get().LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
-					TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
-					ImageWrapper->SetRaw(Thumb.GetUncompressedImageData().GetData(), Thumb.GetUncompressedImageData().Num(), w, h, ERGBFormat::BGRA, 8);
+/**
+ * @brief Write a thumbnail straight from a package file, without loading it.
+ * @param Asset The asset whose thumbnail is wanted
+ * @param pngPath Where to write the png
+ * @return true if the package had a thumbnail for the asset, and it was written.
+ */
 
-					if (ImageWrapper)
-					{
-						FString tpngPath = pngPath;
-						tpngPath.RemoveFromStart(outputDir);
-						tpngPath = "[OutputDir]" + tpngPath;
+bool reporter::createThumbnailFile(FAssetData const& Asset, FString pngPath)
+{
+	FString filename = reportManifest::getPackageFilename(Asset.PackageName);
+	if (filename.IsEmpty())
+		return false;
 
-						LOG(" Writing   " + tpngPath);
+	FString cachePath = getThumbnailCachePath(Asset.PackageName, Asset.GetFullName());
+	bool hasThumbnail;
+	if (readThumbnailCache(cachePath, pngPath, hasThumbnail))
+		return hasThumbnail;
 
-						const TArray64<uint8>& CompressedByteArray = ImageWrapper->GetCompressed();
-						if (!FFileHelper::SaveArrayToFile(CompressedByteArray, *pngPath))
-						{
-							UE_LOG(LOG_DOT, Error, TEXT("Could not save thumbnail: '%s'."), *pngPath);
-							return false;
-						}
+	FName fullName(*Asset.GetFullName());
 
-						return true;
-					}
-				}
-			}
+	TSet<FName> names;
+	names.Add(fullName);
 
-			//UE_LOG(LOG_DOT, Warning, TEXT("Could not find thumbnail: '%s'."), *fullName);
+	//a package saved without thumbnails is cached as having none; an unreadable one (eg: locked) isn't
+	int64 tableOffset;
+	if (!readThumbnailTableOffset(filename, tableOffset))
+		return false;
+
+	if (tableOffset == 0)
+	{
+		writeThumbnailCache(cachePath, TArray<uint8>());
+		return false;
+	}
+
+	FThumbnailMap thumbnails;
+	if (!ThumbnailTools::LoadThumbnailsFromPackage(filename, names, thumbnails))
+		return false;
+
+	FObjectThumbnail* Thumb = thumbnails.Find(fullName);
+	if (!Thumb || !Thumb->GetImageWidth() || !Thumb->GetImageHeight() || !Thumb->GetUncompressedImageData().Num())
+	{
+		writeThumbnailCache(cachePath, TArray<uint8>());	//the package has none for this object
+		return false;
+	}
+
+	return writeThumbnail(*Thumb, pngPath, cachePath);
+}
+
+/**
+ * @brief Read where a package file keeps its thumbnails, from its summary.
+ * @param filename The package file
+ * @param offset Receives the offset of the thumbnail table, or 0 if it has none
+ * @return false if the file could not be read, or isn't a package.
+ */
+
+bool reporter::readThumbnailTableOffset(FString filename, int64& offset)
+{
+	offset = 0;
+
+	TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileReader(*filename));
+	if (!Ar)
+		return false;
+
+	FPackageFileSummary Summary;
+	*Ar << Summary;
+	if (Ar->IsError() || Summary.Tag != PACKAGE_FILE_TAG)
+		return false;
+
+	offset = Summary.ThumbnailTableOffset;
+	return true;
+}
+
+/**
+ * @brief Encode a thumbnail as png, write it, and keep it in the thumbnail cache.
+ * @param Thumb The thumbnail
+ * @param pngPath Where to write the png
+ * @param cachePath From getThumbnailCachePath(), or empty to not cache it
+ * @return true on success, or once the encode is queued on the Writer.
+ *
+ * The pixels are copied here, since the thumbnail belongs to the package (or
+ * the caller), and the encode and writes are handed to the Writer's threads.
+ *
+ * With a Writer, the caller adds its \\image tag and gallery entry before
+ * the png exists, as waiting on the encode would put it back on the game
+ * thread.  The png is queued under its own path, which is already recorded
+ * for the package, so if the encode or write fails, the run fails and the
+ * package is left out of date by reportManifest::invalidateFile(), and its
+ * header is written again next run.
+ */
+
+bool reporter::writeThumbnail(FObjectThumbnail& Thumb, FString pngPath, FString cachePath)
+{
+	if (!ThumbnailEncoder)
+		ThumbnailEncoder = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+
+	int32 w = Thumb.GetImageWidth();
+	int32 h = Thumb.GetImageHeight();
+	TArray<uint8> bgra(Thumb.GetUncompressedImageData());
+
+	//recorded before it is queued, so a failed encode finds its package (see fileWriter::getFailedPaths)
+	addOutputFile(pngPath);
+
+	auto encode = [bgra = MoveTemp(bgra), w, h, pngPath, cachePath]()
+	{
+		TArray<uint8> png;
+		if (!encodePng(bgra, w, h, png))
+		{
+			UE_LOG(LOG_DOT, Error, TEXT("Could not encode thumbnail: '%s'."), *pngPath);
+			return false;
 		}
+
+		writeThumbnailCache(cachePath, png);
+
+		return fileWriter::writeFile(png.GetData(), png.Num(), pngPath);
+	};
+
+	if (Writer)
+	{
+		Writer->queue(pngPath, MoveTemp(encode));
+		return true;
 	}
-	else
+
+	return encode();
+}
+
+/**
+ * @brief Compress BGRA pixels to png.  Safe to call from any thread.
+ * @param bgra The pixels
+ * @param w ..their width
+ * @param h ..and height
+ * @param png Receives the png
+ * @return false if it could not be encoded.
+ */
+
+bool reporter::encodePng(TArray<uint8> const& bgra, int32 w, int32 h, TArray<uint8>& png)
+{
+	check(ThumbnailEncoder);
+
+	TSharedPtr<IImageWrapper> ImageWrapper = ThumbnailEncoder->CreateImageWrapper(EImageFormat::PNG);
+	if (!ImageWrapper.IsValid() || !ImageWrapper->SetRaw(bgra.GetData(), bgra.Num(), w, h, ERGBFormat::BGRA, 8))
+		return false;
+
+	const TArray64<uint8>& CompressedByteArray = ImageWrapper->GetCompressed();
+	png = TArray<uint8>(CompressedByteArray.GetData(), (int32)CompressedByteArray.Num());
+
+	return png.Num() > 0;
+}
+
+/**
+ * @brief Log a file written into the output, and record it in the manifest.
+ * @param fpath The file
+ */
+
+void reporter::addOutputFile(FString fpath)
+{
+	FString tpath = fpath;
+	tpath.RemoveFromStart(outputDir);
+	tpath = "[OutputDir]" + tpath;
+
+	LOG(" Writing   " + tpath);
+
+	if (Manifest)
+		Manifest->addFile(fpath);
+}
+
+/**
+ * @brief Write an encoded png into the output.
+ * @param png The png
+ * @param pngPath Where to write it
+ * @return false if it could not be written.
+ */
+
+bool reporter::writePng(TArray<uint8> png, FString pngPath)
+{
+	addOutputFile(pngPath);
+
+	if (Writer)
+		Writer->write(MoveTemp(png), pngPath);
+	else if (!fileWriter::writeFile(png.GetData(), png.Num(), pngPath))
 	{
-		//UE_LOG(LOG_DOT, Error, TEXT("No linker: '%s'."), *pngPath);
+		UE_LOG(LOG_DOT, Error, TEXT("Could not save thumbnail: '%s'."), *pngPath);
+		return false;
 	}
 
-	return false;
+	return true;
 }
 
-bool reporter::openFile(FString fpath, bool append)
+/**
+ * @brief Where an asset's encoded thumbnail is cached between runs.
+ * @param packageName The asset's package
+ * @param fullName The asset's full name, which its thumbnail is stored under
+ * @return The cache file, or empty if the package has no saved hash to key it by.
+ *
+ * Thumbnails only change when their package is saved, so the cache is keyed
+ * by the package's saved hash (its guid, on UE4) from the asset registry.
+ * An empty cache file means the asset had no thumbnail.
+ *
+ * The file is named for the asset first, then the hash, so that
+ * writeThumbnailCache() can find and drop the entries for older hashes.
+ */
+
+FString reporter::getThumbnailCachePath(FName packageName, FString fullName)
 {
-	closeFile();
+	if (ThumbnailCacheDir.IsEmpty())
+		return FString();
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(AssetRegistryConstants::ModuleName).Get();
+
+	FString hash;
+#if ENGINE_MAJOR_VERSION >= 5
+	TOptional<FAssetPackageData> data = AssetRegistry.GetAssetPackageDataCopy(packageName);
+	if (data.IsSet() && !data->GetPackageSavedHash().IsZero())
+		hash = LexToString(data->GetPackageSavedHash());
+#else
+	const FAssetPackageData* data = AssetRegistry.GetAssetPackageData(packageName);
+	if (data && data->PackageGuid.IsValid())
+		hash = data->PackageGuid.ToString();
+#endif
+
+	if (hash.IsEmpty())
+		return FString();
+
+	return ThumbnailCacheDir / FMD5::HashAnsiString(*fullName) + "-" + hash + ".png";
+}
+
+/**
+ * @brief Write a thumbnail from the cache, if it is there.
+ * @param cachePath From getThumbnailCachePath()
+ * @param pngPath Where to write the png
+ * @param hasThumbnail Receives whether the asset has a thumbnail (and it was written)
+ * @return true if the cache had an answer.
+ */
+
+bool reporter::readThumbnailCache(FString cachePath, FString pngPath, bool& hasThumbnail)
+{
+	hasThumbnail = false;
+
+	TArray<uint8> png;
+	if (cachePath.IsEmpty() || !FFileHelper::LoadFileToArray(png, *cachePath, FILEREAD_Silent))
+		return false;
+
+	if (png.Num())
+		hasThumbnail = writePng(MoveTemp(png), pngPath);
+
+	return true;
+}
 
-	std::ofstream::openmode mode = std::ofstream::out;
-	if (append)
-		mode |= std::ofstream::app;
+/**
+ * @brief Keep a thumbnail in the cache, in place of any from before its package was saved.
+ * @param cachePath From getThumbnailCachePath()
+ * @param png The png, or empty if the asset has no thumbnail
+ *
+ * Safe to call from any thread.
+ */
 
-	std::wofstream* stream = new std::wofstream();
-	//stream->open(*fpath, mode);
+void reporter::writeThumbnailCache(FString cachePath, TArray<uint8> const& png)
+{
+	if (cachePath.IsEmpty())
+		return;
 
-	std::string sfpath(TCHAR_TO_UTF8(*fpath));
-	stream->open(sfpath, mode);
+	//the same asset under an older hash is never read again
+	FString dir = FPaths::GetPath(cachePath);
+	FString name = FPaths::GetCleanFilename(cachePath);
+	FString asset = name.Left(name.Find(TEXT("-")));
 
-	if (stream->is_open())
+	TArray<FString> stale;
+	IFileManager::Get().FindFiles(stale, *(dir / asset + "-*.png"), /*Files =*/true, /*Directories =*/false);
+	for (const FString& s : stale)
 	{
-		out = outfile = stream;
+		if (s != name)
+			IFileManager::Get().Delete(*(dir / s));
+	}
+
+	//straight to disk, never into an -OutputArchive
+	if (!FFileHelper::SaveArrayToFile(png, *cachePath))
+		UE_LOG(LOG_DOT, Warning, TEXT("Could not cache thumbnail: '%s'."), *cachePath);
+}
+
+/**
+ * @brief Set currentDir for a package.
+ * @param packageName The long package name
+ * @return true.  The folder itself is made by the first write into it.
+ */
+
+bool reporter::setCurrentDir(FString packageName)
+{
+	FString subDir = FPaths::GetPath(packageName);		//chop the "file" entry off
+	subDir.RemoveFromStart("/");				//remove prefix slash from UFS path
+	currentDir = outputDir + "/" + subDir;			//jam it all together
+	FPaths::NormalizeDirectoryName(currentDir);		//fix/normalize the slashes
+
+	return true;
+}
+
+/**
+ * @brief Let a finished package be collected by the next garbage collection.
+ * @param package The package of an asset that has been emitted.
+ *
+ * Loaded assets are RF_Standalone, which keeps them alive with nothing
+ * referencing them.  Clearing it leaves the package to GC once nothing else
+ * holds it.  Its loader is reset by trackMemory() just before collecting,
+ * as ResetLoaders() would otherwise wait on the prefetches in flight.
+ * Rooted packages (still in the prefetch window, or rooted by the editor)
+ * are left alone.
+ */
+
+void reporter::releasePackage(UPackage* package)
+{
+	if (!package || package->IsRooted())
+		return;
+
+	ForEachObjectWithPackage(package, [](UObject* object)
+	{
+		object->ClearFlags(RF_Standalone);
+		return true;
+	});
+	package->ClearFlags(RF_Standalone);
+	ReleasedPackages.Add(package);
+}
+
+/**
+ * @brief Release a finished package, and collect garbage over budget.
+ * @param prefetcher The loader for the current report loop.
+ * @param finished The package of the asset just emitted.
+ *
+ * Called after each asset is emitted.  When reporter::MemoryBudgetMB is set,
+ * the finished package is released, and once resident memory is above the
+ * budget, `CollectGarbage()` reclaims the released packages.  Packages still
+ * waiting in the prefetch window are rooted, so they survive.
+ */
+
+void reporter::trackMemory(packagePrefetcher& prefetcher, UPackage* finished)
+{
+	FPlatformMemoryStats stats = FPlatformMemory::GetStats();
+	uint64 usedMB = stats.UsedPhysical / (1024 * 1024);
+
+	PeakMemoryMB = FMath::Max(PeakMemoryMB, usedMB);
+
+	if (MemoryBudgetMB <= 0)
+		return;
+
+	releasePackage(finished);
+
+	if (usedMB < (uint64)MemoryBudgetMB)
+		return;
+
+	prefetcher.flush();				//no loads in progress while collecting
+
+	for (TWeakObjectPtr<UPackage> const& package : ReleasedPackages)
+	{
+		if (package.IsValid())
+			ResetLoaders(package.Get());
+	}
+	ReleasedPackages.Empty();
+
+	//these point at objects from the finished asset
+	GraphDescriptions.Empty();
+	Graph = graphIR();
+	NodeIndex.Empty();
+	PinIndex.Empty();
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	NumGCPasses++;
+
+	uint64 afterMB = FPlatformMemory::GetStats().UsedPhysical / (1024 * 1024);
+	UE_LOG(LOG_DOT, Display, TEXT("Memory %llu MB is over budget (%d MB).  Collected garbage: now %llu MB."), usedMB, MemoryBudgetMB, afterMB);
+}
+
+bool reporter::openFile(FString fpath, bool append)
+{
+	closeFile();
+
+	//the file is built in memory, and written (or handed to the Writer) by closeFile()
+	if (output.open(fpath, append, Writer))
+	{
+		out = &output;
+
+		if (Manifest)
+			Manifest->addFile(fpath);
 
 		FString tpath = fpath;
 		tpath.RemoveFromStart(outputDir);
@@ -1508,7 +2123,8 @@ bool reporter::openFile(FString fpath, bool append)
 	}
 	else
 	{
-		out = &std::wcout;
+		output.openStdout();
+		out = &output;
 		wcerr << "Error opening file: '" << *fpath << "'" << endl;
 		return false;
 	}
@@ -1518,18 +2134,10 @@ bool reporter::openFile(FString fpath, bool append)
 
 bool reporter::closeFile()
 {
-	if (outfile)
-	{
-		if (outfile->is_open())
-			outfile->close();
-
-		delete outfile;
-		outfile = NULL;
-
-		return true;
-	}
+	if (!output.isFile())
+		return false;
 
-	return false;
+	return output.close();
 }
 
 void reporter::LOG(FString message)
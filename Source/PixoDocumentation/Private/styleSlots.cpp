@@ -0,0 +1,144 @@
+// (c) 2023 PixoVR
+
+#include "styleSlots.h"
+
+//in StyleKey order
+static const TCHAR* StyleKeyNames[] = {
+	TEXT("_STYLESHEET_"),
+	TEXT("_GRAPHBG_"),
+	TEXT("_FONTNAME_"),
+	TEXT("_FONTSIZE_"),
+	TEXT("_FONTSIZE2_"),
+	TEXT("_FONTCOLOR_"),
+	TEXT("_FONTSIZEPORT_"),
+	TEXT("_FONTSIZECOMMENT_"),
+	TEXT("_FONTSIZEBUBBLE_"),
+	TEXT("_FONTCOLORBUBBLE_"),
+	TEXT("_NODECOLOR_"),
+	TEXT("_NODECOLORTRANS_"),
+	TEXT("_VALCOLOR_"),
+	TEXT("_BORDERCOLOR_"),
+	TEXT("_EDGECOLOR_"),
+	TEXT("_EDGETHICKNESS_"),
+	TEXT("_PINDEFAULTCOLOR_"),
+	TEXT("_PINURL_"),
+	TEXT("_CELLPADDING_"),
+	TEXT("_COMMENTPADDING_"),
+	TEXT("_COMPOSITEPADDING_"),
+	TEXT("_COMPACTCOLOR_"),
+	TEXT("_COMPACTSIZE_"),
+	TEXT("_COMPACTWIDTH_"),
+	TEXT("_HEIGHTSPACER_"),
+
+	TEXT("_NODENAME_"),
+	TEXT("_NODEGUID_"),
+	TEXT("_NODEICON_"),
+	TEXT("_NODEDELEGATE_"),
+	TEXT("_NODETITLE_"),
+	TEXT("_NODETITLE2_"),
+	TEXT("_NODECOMMENT_"),
+	TEXT("_POS_"),
+	TEXT("_WIDTH_"),
+	TEXT("_HEIGHT_"),
+	TEXT("_TOOLTIP_"),
+	TEXT("_HEADERCOLOR_"),
+	TEXT("_HEADERCOLORDIM_"),
+	TEXT("_HEADERCOLORLIGHT_"),
+	TEXT("_HEADERCOLORTRANS_"),
+	TEXT("_HEADERTEXTCOLOR_"),
+	TEXT("_CLASS_"),
+	TEXT("_URL_"),
+	TEXT("_PORTROWS_"),
+
+	TEXT("_PINCOLOR_"),
+	TEXT("_INPORT_"),
+	TEXT("_INICON_"),
+	TEXT("_INLABEL_"),
+	TEXT("_INCOLOR_"),
+	TEXT("_INVALUE_"),
+	TEXT("_INTOOLTIP_"),
+	TEXT("_OUTPORT_"),
+	TEXT("_OUTICON_"),
+	TEXT("_OUTLABEL_"),
+	TEXT("_OUTCOLOR_"),
+	TEXT("_OUTVALUE_"),
+	TEXT("_OUTTOOLTIP_")
+};
+
+static_assert(UE_ARRAY_COUNT(StyleKeyNames) == (int32)StyleKey::MAX, "StyleKeyNames must match StyleKey.");
+static_assert((int32)StyleKey::MAX <= 64, "styleSlots::isSet has a bit per StyleKey.");
+
+/**
+ * @brief styleSlots::styleSlots
+ * @param _base The layer to fall back to, or NULL
+ */
+
+styleSlots::styleSlots(styleSlots const* _base)
+: base(_base)
+{
+}
+
+styleSlots::~styleSlots()
+{
+}
+
+void styleSlots::set(StyleKey key, FString value)
+{
+	values[(int32)key] = MoveTemp(value);
+	isSet |= 1ull << (int32)key;
+}
+
+/**
+ * @brief The value of a slot, from this layer or the first base that has it.
+ * @param key The slot
+ * @return The value, or NULL if no layer has it.
+ */
+
+const FString* styleSlots::find(StyleKey key) const
+{
+	uint64 bit = 1ull << (int32)key;
+	for (const styleSlots* s = this; s; s = s->base)
+	{
+		if (s->isSet & bit)
+			return &s->values[(int32)key];
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Clear this layer, leaving the base.
+ */
+
+void styleSlots::reset()
+{
+	for (FString& v : values)
+		v.Reset();
+	isSet = 0;
+}
+
+/**
+ * @brief The slot named in a template.
+ * @param name The name, with its underscores.  eg: "_NODETITLE_"
+ * @return The slot, or StyleKey::MAX if there is none by that name.
+ */
+
+StyleKey styleSlots::findKey(FString const& name)
+{
+	//filled whole on the first call, and only read after that, so safe from any thread
+	static const TMap<FString, StyleKey> keys = []()
+	{
+		TMap<FString, StyleKey> k;
+		for (int32 i = 0; i < (int32)StyleKey::MAX; i++)
+			k.Add(StyleKeyNames[i], (StyleKey)i);
+		return k;
+	}();
+
+	const StyleKey* key = keys.Find(name);		//case insensitive, like the Replace() this took over from
+	return key ? *key : StyleKey::MAX;
+}
+
+const TCHAR* styleSlots::getName(StyleKey key)
+{
+	return key < StyleKey::MAX ? StyleKeyNames[(int32)key] : TEXT("");
+}
@@ -0,0 +1,192 @@
+// (c) 2023 PixoVR
+
+#include "tarArchive.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/ScopeLock.h"
+
+#include "reporter.h"
+
+static const int32 TarBlock = 512;
+
+//a ustar header, which is one block
+struct tarHeader
+{
+	ANSICHAR	name[100];
+	ANSICHAR	mode[8];
+	ANSICHAR	uid[8];
+	ANSICHAR	gid[8];
+	ANSICHAR	size[12];
+	ANSICHAR	mtime[12];
+	ANSICHAR	checksum[8];
+	ANSICHAR	type;
+	ANSICHAR	linkname[100];
+	ANSICHAR	magic[6];
+	ANSICHAR	version[2];
+	ANSICHAR	uname[32];
+	ANSICHAR	gname[32];
+	ANSICHAR	devmajor[8];
+	ANSICHAR	devminor[8];
+	ANSICHAR	prefix[155];
+	ANSICHAR	pad[12];
+};
+
+static_assert(sizeof(tarHeader) == TarBlock, "A tar header is one block.");
+
+/**
+ * @brief tarArchive::tarArchive
+ * @param _path The .tar file to write
+ * @param _root The output directory, which entry names are relative to
+ */
+
+tarArchive::tarArchive(FString _path, FString _root)
+: path(_path)
+, root(_root)
+{
+	FPaths::NormalizeFilename(root);
+	if (!root.IsEmpty() && !root.EndsWith("/"))
+		root += "/";
+}
+
+tarArchive::~tarArchive()
+{
+	close();
+}
+
+/**
+ * @brief Create (or replace) the archive.
+ * @return false if it could not be created.
+ */
+
+bool tarArchive::open()
+{
+	close();
+
+	file = IFileManager::Get().CreateFileWriter(*path);
+	if (!file)
+	{
+		UE_LOG(LOG_DOT, Error, TEXT("Could not open archive '%s' for writing."), *path);
+		return false;
+	}
+
+	numEntries = 0;
+	timestamp = FDateTime::UtcNow().ToUnixTimestamp();
+
+	return true;
+}
+
+/**
+ * @brief Finish the archive with its two empty blocks.
+ * @return false if there was no archive, or it could not be written.
+ */
+
+bool tarArchive::close()
+{
+	FScopeLock scope(&lock);
+
+	if (!file)
+		return false;
+
+	uint8 end[TarBlock * 2] = {};
+	file->Serialize(end, sizeof(end));
+
+	bool ok = file->Close();
+	delete file;
+	file = NULL;
+
+	if (!ok)
+		UE_LOG(LOG_DOT, Error, TEXT("Could not write archive '%s'."), *path);
+
+	return ok;
+}
+
+/**
+ * @brief Append a file.
+ * @param fpath The file's path in the output directory
+ * @param data The file
+ * @param size ..and its size
+ * @return false if the archive isn't open, or the entry could not be written.
+ */
+
+bool tarArchive::add(FString fpath, const uint8* data, int64 size)
+{
+	FPaths::NormalizeFilename(fpath);
+	fpath.RemoveFromStart(root);
+	fpath.RemoveFromStart("/");
+
+	FScopeLock scope(&lock);
+
+	if (!file)
+		return false;
+
+	if (!writeHeader(fpath, size, '0') || !writePadded(data, size))
+		return false;
+
+	numEntries++;
+	return true;
+}
+
+bool tarArchive::writeHeader(FString const& name, int64 size, ANSICHAR type)
+{
+	FTCHARToUTF8 utf8(*name, name.Len());
+
+	//too long for the header, so the name goes first in an entry of its own
+	if (utf8.Length() > (int32)sizeof(tarHeader::name))
+	{
+		if (!writeHeader("././@LongLink", utf8.Length() + 1, 'L'))
+			return false;
+
+		TArray<uint8> longName((const uint8*)utf8.Get(), utf8.Length());
+		longName.Add(0);
+		if (!writePadded(longName.GetData(), longName.Num()))
+			return false;
+	}
+
+	tarHeader h;
+	FMemory::Memzero(h);
+
+	FMemory::Memcpy(h.name, utf8.Get(), FMath::Min<int32>(utf8.Length(), sizeof(h.name)));
+	setOctal(h.mode, UE_ARRAY_COUNT(h.mode), 0644);
+	setOctal(h.uid, UE_ARRAY_COUNT(h.uid), 0);
+	setOctal(h.gid, UE_ARRAY_COUNT(h.gid), 0);
+	setOctal(h.size, UE_ARRAY_COUNT(h.size), size);
+	setOctal(h.mtime, UE_ARRAY_COUNT(h.mtime), timestamp);
+	h.type = type;
+	FMemory::Memcpy(h.magic, "ustar", 6);
+	FMemory::Memcpy(h.version, "00", 2);
+
+	//summed with the checksum field as spaces
+	FMemory::Memset(h.checksum, ' ', UE_ARRAY_COUNT(h.checksum));
+	uint32 sum = 0;
+	for (int32 i = 0; i < TarBlock; i++)
+		sum += ((const uint8*)&h)[i];
+	setOctal(h.checksum, 7, sum);
+
+	return writePadded((const uint8*)&h, TarBlock);
+}
+
+bool tarArchive::writePadded(const uint8* data, int64 size)
+{
+	file->Serialize(const_cast<uint8*>(data), size);
+
+	uint8 zeros[TarBlock] = {};
+	int64 pad = (TarBlock - size % TarBlock) % TarBlock;
+	if (pad)
+		file->Serialize(zeros, pad);
+
+	return !file->IsError();
+}
+
+/**
+ * @brief Fill a header field with a zero padded octal number, and a NUL.
+ */
+
+void tarArchive::setOctal(ANSICHAR* field, int32 width, int64 value)
+{
+	field[width - 1] = 0;
+	for (int32 i = width - 2; i >= 0; i--)
+	{
+		field[i] = '0' + (value & 7);
+		value >>= 3;
+	}
+}
@@ -6,6 +6,8 @@
 
 #include "CoreMinimal.h"
 
+#include "compiledTemplate.h"
+
 #if PLATFORM_LINUX
 /**
  * @brief operator <<
@@ -53,7 +55,8 @@ namespace DocUtils
 		verbose	= 0x1 << 0,
 		debug	= 0x1 << 1,
 		doxygen	= 0x1 << 2,
-		MAX	= 0x1 << 3
+		index	= 0x1 << 3,		//doxygen headers from asset registry tags only
+		MAX	= 0x1 << 4
 	};
 
 	TMap<FString, OutputMode> OutputMode_e = {
@@ -61,6 +64,7 @@ namespace DocUtils
 		{ "verbose",	OutputMode::verbose	},
 		{ "debug",		OutputMode::debug	},
 		{ "doxygen",	OutputMode::doxygen	},
+		{ "index",		OutputMode::index	},
 		{ "MAX",		OutputMode::MAX		}
 	};
 
@@ -165,16 +169,21 @@ namespace DocUtils
 	void RGBtoHSL(float R, float G, float B, float* h, float* s, float* l);
 	void HSLtoRGB(float H, float S, float L, float* r, float* g, float* b);
 
+	void convertColors(FLinearColor const* in, FLinearColor* out, int32 num, float exponent = 1.0f);
 	FString createColorString(FLinearColor color, float alpha = 1.0f, float exponent = 1.0f);
+	void createColorStrings(TArray<FLinearColor> const& colors, TArray<FString>& strings, float alpha = 1.0f, float exponent = 1.0f);
 	FString createVariableName(FString name);
 
 	bool createThumbnailFile(UObject* object, FString pngPath);
 
 	FString getClassName(UClass* _class);
+	FString getClassPrefix(UClass* _class, bool isDeprecated);
 
 	//file stuff
 	FString getTrimmedConfigFilePath(FString path);
-	FString prepTemplateString(FString prefix, vmap style, FString string);
+	FString prepTemplateString(FString prefix, styleSlots const& style, FString string);
+	FString renderTemplate(FString prefix, compiledTemplate const& t, styleSlots const& style);
+	FString indentTemplateString(FString prefix, FString h);
 	FString prepNodePortRows(FString prefix, UEdGraphNode* node, TMap<FString, FString> visiblePins = TMap<FString, FString>());
 
 	//graph stuff
@@ -185,13 +194,16 @@ namespace DocUtils
 	FString getNodeTypeGroup(NodeType type);
 	FString getNodeTooltip(UEdGraphNode* node);
 	FString getNodeIcon(UEdGraphNode* node);
+	FString getNodeIcon(NodeType type);
 	FString getNodeTemplate(NodeType type, bool hasDelegate=false);
+	compiledTemplate const& getCompiledNodeTemplate(NodeType type, bool hasDelegate=false);
 
 	//pin stuff
 	FString getPinLabel(UEdGraphPin* pin);
 	FString getPinTooltip(UEdGraphPin* p, TMap<FString,FString>visiblePins = TMap<FString, FString>());
 	FString getPinType(UEdGraphPin* pin, bool useSchema=false);
 	FString getPinPort(UEdGraphPin* p);
+	FString getPinPort(UEdGraphPin* p, bool isRoute);
 	FString getPinDefaultValue(UEdGraphPin* pin);
 	FString getPinColor(UEdGraphPin* pin);
 	FString getPinIcon(UEdGraphPin* pin);
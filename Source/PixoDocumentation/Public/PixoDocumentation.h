@@ -3,6 +3,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "AssetRegistry/AssetData.h"
+
+class reportManifest;
 
 /**
  * @brief The PixoDocumentation class
@@ -37,9 +40,29 @@ public:
 	virtual ~PixoDocumentation();
 
 	int32 report();
+	int32 merge(int32 shards);
+	int32 serve(FString address);
+
+	//options
+	void setPrefetch(int32 _prefetch)		{ prefetch = _prefetch; }
+	void setMemoryBudget(int32 _megabytes)	{ memoryBudget = _megabytes; }
+	void setShard(int32 _shard, int32 _shards)	{ shard = _shard; numShards = _shards; }
+	void setFull(bool _full)			{ full = _full; }
+	void setArchive(FString _archive)		{ archive = _archive; }
+	void setGalleryAtlas(bool _atlas)		{ galleryAtlasMode = _atlas; }
 
 protected:
+	virtual bool discoverAssets();
+	virtual bool openManifest();
+	virtual void invalidateReferencers(TArray<FName> const& changed);
+	virtual void refreshPackages(TArray<FName> const& packages);
 	virtual bool clearGroups();
+	virtual bool writeGroups();
+	virtual bool isInShard(FAssetData const& Asset);
+
+	FString getShardStatePath(int32 _shard, int32 _shards);
+	FString writeShardState();
+	bool readShardState(FString const& json);
 	virtual void reportResults();
 
 private:
@@ -50,12 +73,29 @@ private:
 	TArray<FString> includes;
 	FString		stylesheet = "doxygen-pixo.css";	// style applied to dot/svg
 	FString		groups = "groups.dox";			// filename for groups file
+	int32		prefetch = 8;				// packages loaded ahead of emission (0 = off)
+	int32		memoryBudget = 0;			// MB of resident memory before collecting garbage (0 = off)
+	int32		shard = 0;				// this process's shard, from -Shard=i/N
+	int32		numShards = 0;				// number of shards (0 or 1 = not sharded)
+	bool		full = false;				// ignore the manifest, and regenerate everything
+	FString		archive = "";				// stream output into this tar file, instead of the OutputDir (empty = off)
+	bool		galleryAtlasMode = false;		// pack each group's gallery into sprite sheets
+
+	reportManifest*	manifest = NULL;			// what the last run produced, for incremental runs
+	TSet<FName>	forcedPackages;				// emitted even if unchanged (-Serve requests)
+	bool		rescan = false;				// rescan the include roots, even if already scanned (-Serve "all")
+
+	/** The single include-scoped discovery pass, shared with every reporter */
+	TArray<FAssetData> blueprintAssets;
+	TArray<FAssetData> materialAssets;
+	TSet<FName> discoveredPackages;			// before sharding
 
 	/** Variables to store overall results */
 	int totalGraphsProcessed;
 	int totalBlueprintsIgnored;
 	int totalMaterialsIgnored;
 	int totalNumFailedLoads;
+	int totalNumFailedWrites;
 
 	//TODO: activate this?
 	TArray<FString> AssetsWithErrorsOrWarnings;
@@ -50,5 +50,15 @@ private:
 	TArray<FString>	includes;
 	FString		stylesheet = "doxygen-pixo.css";
 	FString		groups = "groups.dox";			// filename for groups file
+	int32		prefetch = 8;				// packages loaded ahead of emission
+	int32		memoryBudget = 0;			// MB before collecting garbage between assets
+	int32		shard = 0;				// -Shard=i/N
+	int32		numShards = 0;
+	int32		mergeShards = 0;			// -MergeShards=N
+	bool		full = false;				// -Full: ignore the manifest
+	bool		serve = false;				// -Serve[=address]: stay resident
+	FString		serveAddress = "";
+	FString		outputArchive = "";			// -OutputArchive=docs.tar
+	bool		galleryAtlasMode = false;		// -GalleryAtlas: gallery thumbnails as sprite sheets
 
 };
@@ -4,6 +4,27 @@
 
 #include "reporter.h"
 
+/**
+ * @brief Everything written in a blueprint's class header.
+ *
+ * Filled either from a loaded UBlueprint, or from asset registry tags when
+ * reporting an index (see reporter::IndexOnly).
+ */
+
+struct blueprintHeaderData
+{
+	FString		className;
+	FString		parentClass;
+	FString		packageName;
+	FString		brief;
+	FString		imageTag;
+	FString		config;
+	FString		displayName;
+	FString		description;
+	bool		isDataOnly = false;
+	bool		isDeprecated = false;
+};
+
 class blueprintReporter : public reporter
 {
 public:
@@ -17,6 +38,7 @@ protected:
 	virtual void LOG(FString verbosity,FString message) override;
 
 	virtual int reportBlueprint(FString prefix, UBlueprint* Blueprint) override;
+	virtual int reportBlueprintIndex(FAssetData const& Asset);
 	virtual void reportGraph(FString prefix, UEdGraph* g) override;
 	virtual void reportNode(FString prefix, UEdGraphNode* Node) override;
 
@@ -28,5 +50,8 @@ private:
 		FString packageName,
 		int graphCount
 	);
+	void writeBlueprintHeader(blueprintHeaderData const& header, FString group, FString qualifier);
 	void writeBlueprintMembers(UBlueprint* blueprint, FString what);
+
+	FString getTagClassName(FAssetData const& Asset, FName tag, UClass* nativeParent);
 };
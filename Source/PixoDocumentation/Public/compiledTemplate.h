@@ -0,0 +1,86 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "styleSlots.h"
+
+/**
+ * @brief A node or row template, parsed once into literals and slots.
+ *
+ * A slot is a StyleKey, written as its name between underscores, eg:
+ * "_NODETITLE_", and is looked up once when compiling.  Rendering walks the
+ * tokens once and appends either the literal text or the slot's value from
+ * a styleSlots, instead of running a Replace() over the whole template for
+ * every style key.
+ *
+ * A value may itself name slots (eg: "_PINDEFAULTCOLOR_"), and these are
+ * expanded once, the same as the second Replace() pass used to do.  A slot
+ * without a value is left in the output as is.
+ *
+ * An element whose content is only slots (or other such elements) is
+ * conditional, and is dropped whole if its content renders empty.  These
+ * are the elements that used to be cleaned up after rendering:
+ *
+ * - `<font ...>_SLOT_</font>`
+ * - `<b>_SLOT_</b>`
+ * - `<br/><i>_SLOT_</i>`, with none, one or four `&nbsp;` after the `<br/>`
+ *
+ * A `<font>` is kept if a value put a tag into its attributes.  Content of
+ * only '\\r' is empty too when there is no prefix to indent it with.
+ *
+ * \sa DocUtils::renderTemplate
+ */
+
+class compiledTemplate
+{
+public:
+	compiledTemplate();
+	compiledTemplate(FString source);
+	virtual ~compiledTemplate();
+
+	void compile(FString source);
+	void render(FString& out, styleSlots const& style, bool emptyCR = false) const;
+
+	bool isEmpty() const		{ return tokens.Num() == 0; }
+
+protected:
+	enum tokenType : uint8
+	{
+		literal,
+		slot,
+		elementBegin,		//a conditional element starts here
+		contentBegin,		//..and its content here
+		contentEnd,		//if nothing was rendered since contentBegin, roll back to elementBegin and skip to elementEnd
+		elementEnd
+	};
+
+	struct token
+	{
+		tokenType	type = literal;
+		int32		start = 0;		//into text
+		int32		len = 0;
+		StyleKey	key = StyleKey::MAX;	//for a slot
+		int32		skip = INDEX_NONE;	//for contentEnd, the index of its elementEnd
+		bool		hasAttributes = false;	//for contentEnd, the opening tag has attributes
+	};
+
+	void compileRange(int32 from, int32 to, bool elements);
+	void addLiteral(int32 from, int32 to);
+	int32 addToken(tokenType type);
+
+	bool findElement(int32 p, int32 to, int32& contentFrom, int32& contentTo, int32& elementTo, bool* hasAttributes = NULL) const;
+	bool isConditional(int32 from, int32 to) const;
+	bool startsWith(int32 p, int32 to, const TCHAR* s) const;
+
+	static bool hasTag(FString const& out, int32 from, int32 to);
+	static bool isBlank(FString const& out, int32 from, bool emptyCR);
+	static int32 slotLength(const TCHAR* p, const TCHAR* end);
+	static StyleKey findSlot(const TCHAR* p, const TCHAR* end, int32& len);
+	static void appendExpanded(FString& out, FString const& value, styleSlots const& style);
+
+private:
+	FString			text;
+	TArray<token>	tokens;
+};
@@ -0,0 +1,57 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_WINDOWS
+#include "HAL/PlatformNamedPipe.h"
+#endif
+
+/**
+ * @brief A local, line based request channel for `-Serve`.
+ *
+ * A Unix domain socket on Linux and Mac, and a named pipe on Windows.  One
+ * client is served at a time:
+ *
+ * - the client writes one request per line, then an empty line (or closes
+ *   its end).  A request is a long package name ("/Game/Folder/BP_Thing"),
+ *   "all" to pick up whatever changed on disk, or "quit".
+ * - the server writes a single status line back, and disconnects.
+ *
+ * eg: `printf '/Game/Folder/BP_Thing\n\n' | nc -U Saved/PixoDocumentation.sock`
+ *
+ * \sa PixoDocumentation::serve
+ */
+
+class docServer
+{
+public:
+	docServer(FString _address);
+	virtual ~docServer();
+
+	bool open();
+	void close();
+
+	bool accept(TArray<FString>& lines);
+	bool reply(FString line);
+	void disconnect();
+
+	FString getAddress() const		{ return address; }
+
+	static FString getDefaultAddress();
+
+protected:
+	bool readByte(ANSICHAR& c);
+
+private:
+	FString		address;
+
+#if PLATFORM_WINDOWS
+	FPlatformNamedPipe	pipe;
+	bool			created = false;
+#else
+	int		listenFd = -1;
+	int		clientFd = -1;
+#endif
+};
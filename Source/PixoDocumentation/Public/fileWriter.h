@@ -0,0 +1,71 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include <atomic>
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "HAL/CriticalSection.h"
+
+class tarArchive;
+
+/**
+ * @brief Writes finished files on the thread pool.
+ *
+ * A reporter hands over a whole file (see outputSink::close) and moves on to
+ * the next asset, while the write, and any folders it needs, are done in the
+ * background.  Up to `window` writes are kept in flight; handing over one
+ * more waits for the oldest.  A file that is already queued is finished
+ * before it is written again, so writes to one path stay in order.
+ *
+ * Work that ends in a write, like encoding a thumbnail, can be queued the
+ * same way, so it runs in parallel too.
+ *
+ * flush() (or the destructor) waits for everything queued.  Writes that fail
+ * are logged and counted, and their paths kept, so after flush() the caller
+ * can see them with getNumFailed() and getFailedPaths().
+ *
+ * Without a thread pool, files are written straight away.
+ *
+ * With an Archive, files are added to it instead of being written to disk.
+ *
+ * \sa reporter::Writer
+ */
+
+class fileWriter
+{
+public:
+	fileWriter(int32 _window = 32);
+	virtual ~fileWriter();
+
+	void write(TArray<uint8> data, FString fpath, bool append = false);
+	void queue(FString fpath, TUniqueFunction<bool()> work);
+	void flush();
+
+	int32 getNumFailed() const		{ return numFailed; }
+	TArray<FString> getFailedPaths();
+
+	static bool writeFile(const uint8* data, int64 size, FString const& fpath, bool append = false);
+
+	static std::atomic<int32>	NumWritten;		//files written this run
+	static std::atomic<int32>	NumUnchanged;		//files left as they were, because they matched
+	static tarArchive*			Archive;		//where files go for -OutputArchive, or NULL for the output directory
+
+protected:
+	struct job
+	{
+		FString			path;
+		TFuture<void>	done;
+	};
+
+	void wait(int32 index);
+	void fail(FString const& fpath);
+
+private:
+	int32				window = 0;
+	TArray<job>			inflight;			//oldest first
+	std::atomic<int32>	numFailed;			//writes queued here that did not succeed
+	TArray<FString>		failedPaths;		//..and their paths
+	FCriticalSection	failedLock;			//for failedPaths, which any thread can add to
+};
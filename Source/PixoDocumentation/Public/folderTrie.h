@@ -0,0 +1,68 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief Include and ignore folders, compiled into a trie of path segments.
+ *
+ * Each folder is split on '/' into FName segments, so a lookup walks the
+ * path once and compares names instead of strings.  An object path is also
+ * split on '.' and ':', so "/Plugin/Folder" matches "/Plugin/Folder/BP.BP_C"
+ * and "/Plugin/Folder/BP" matches "/Plugin/Folder/BP.BP_C:EventGraph".
+ *
+ * A segment may be a glob, with '*' and '?' matching within the segment
+ * (eg: "/Plugin/Test*"), and a segment of just "**" matches any number of
+ * segments.
+ *
+ * A folder matches everything below it, and ignore beats include.
+ *
+ * Matching doesn't allocate: the segments are looked up with FNAME_Find
+ * (a segment that was never a name can't match a literal), and the active
+ * nodes live in an inline array.
+ *
+ * \sa reporter::shouldReportAsset
+ * \sa reporter::shouldReportObject
+ */
+
+class folderTrie
+{
+public:
+	folderTrie();
+	virtual ~folderTrie();
+
+	void reset();
+	void add(FString folder, bool ignore);
+
+	bool matches(FStringView path) const;
+
+	static bool isGlob(FStringView segment);
+
+protected:
+	enum matchFlags : uint8
+	{
+		none	= 0x0 << 0,
+		include	= 0x1 << 0,
+		ignore	= 0x1 << 1
+	};
+
+	struct node
+	{
+		TMap<FName, int32>		children;			//literal segments
+		TArray<TPair<FString, int32>>	globs;				//segments with '*' or '?'
+		int32				anyDepth = INDEX_NONE;		//"**"
+		bool				isAnyDepth = false;		//this is a "**" node, which loops on any segment
+		uint8				flags = none;
+	};
+
+	typedef TArray<int32, TInlineAllocator<32>> stateList;
+
+	int32 addChild(int32 parent, FStringView segment);
+	void activate(int32 n, stateList& states, uint8& found) const;
+
+	static bool globMatch(const TCHAR* pattern, const TCHAR* patternEnd, const TCHAR* text, const TCHAR* textEnd);
+
+private:
+	TArray<node>	nodes;		//nodes[0] is the root
+};
@@ -0,0 +1,73 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IImageWrapperModule;
+
+/**
+ * @brief A group's gallery, packed into a few sprite sheets, for `-GalleryAtlas`.
+ *
+ * Each gallery entry's png (already written for its class page) is read back,
+ * scaled to fit a CellSize square, and packed into sheets of Columns x Rows
+ * cells, named `gallery-[group]-[n].png` in the output directory.
+ *
+ * formatItems() then gives the gallery with each `\image` replaced by a span
+ * that shows its sprite, a `<style>` block mapping each span to its sheet and
+ * offset, and hidden `\image` commands so doxygen copies the sheets into the
+ * html output.  An entry whose png can't be read, or whose sheet can't be
+ * written, is kept as it was.
+ *
+ * \sa reporter::formatGroup
+ */
+
+class galleryAtlas
+{
+public:
+	galleryAtlas(FString _outputDir, FString _groupName);
+	virtual ~galleryAtlas();
+
+	int32 build(TArray<FString> const& entries);
+	FString formatItems() const;
+
+	int32 getNumSheets() const		{ return numSheets; }
+	int32 getNumFailed() const		{ return numFailed; }
+
+	void removeStaleSheets() const;
+
+	static const int32 CellSize = 256;
+	static const int32 Columns = 8;
+	static const int32 Rows = 8;
+
+protected:
+	struct sprite
+	{
+		FString		entry;				//the original gallery entry
+		FString		className;
+		int32		sheet = INDEX_NONE;		//or INDEX_NONE, to use the entry as is
+		int32		x = 0;
+		int32		y = 0;
+		int32		w = 0;
+		int32		h = 0;
+	};
+
+	bool parseEntry(FString const& entry, FString& className, FString& pngPath) const;
+	bool loadImage(FString const& pngPath, TArray<uint8>& bgra, int32& w, int32& h) const;
+	void finishSheet(TArray<uint8> const& sheet, int32 rows);
+	bool writeSheet(int32 index, TArray<uint8> const& bgra, int32 w, int32 h) const;
+
+	FString getSheetName(int32 index) const;
+	FString getSheetClass(int32 index) const;
+	FString getSpriteClass(int32 index) const;
+
+	static void blit(TArray<uint8> const& src, int32 sw, int32 sh, TArray<uint8>& dst, int32 dstride, int32 dx, int32 dy, int32 dw, int32 dh);
+
+private:
+	FString				outputDir;
+	FString				name;				//the group name, usable in a file name
+	TArray<sprite>			sprites;			//sorted, as the gallery is
+	int32				numSheets = 0;
+	int32				numFailed = 0;			//sheets that could not be written
+	IImageWrapperModule*		imageWrapper = NULL;
+};
@@ -0,0 +1,98 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "DocUtils.h"
+
+/**
+ * @brief A visible pin, copied out of its UEdGraphPin.
+ *
+ * Every visible pin gets a port and a color, for the connections.  Pins that
+ * have a row on their node (see graphNode::inputs) also get the rest.  A pin
+ * on a node outside the graph's node list, that a connection still reaches,
+ * has no node, and names its owner instead.
+ */
+
+struct graphPin
+{
+	int32			node = INDEX_NONE;	//in graphIR::nodes
+	FString			owner;			//the dot node name, when node is INDEX_NONE
+	bool			ownerIsRoute = false;
+	FString			port;
+	FString			color;
+	FString			icon;
+	FString			label;
+	FString			value;			//the default value, or empty if connected
+	FString			tooltip;
+};
+
+/**
+ * @brief A connection between two pins, kept once whichever end it was found from.
+ */
+
+struct graphEdge
+{
+	int32			source = INDEX_NONE;	//the output pin, in graphIR::pins
+	int32			dest = INDEX_NONE;	//the input pin
+	int32			colorPin = INDEX_NONE;	//the pin whose color the edge takes
+};
+
+/**
+ * @brief Everything written about a node, copied out of its UEdGraphNode.
+ */
+
+struct graphNode
+{
+	FString			name;			//the dot node name
+	FString			guid;
+	DocUtils::NodeType	type = DocUtils::NodeType::node;
+	FString			typeGroup;		//the css class
+	FString			title;
+	FString			title2;
+	FString			compactTitle;		//for NodeType::compact, when the node draws one
+	bool			hasCompactTitle = false;
+	FString			tooltip;
+	FString			url;
+	FString			delegateIcon;
+	bool			hasDelegate = false;
+	FString			headerColor;
+	FString			headerColorDim;
+	FString			headerColorLight;
+	FString			headerColorTrans;
+	FString			headerTextColor;
+	FString			comment;		//as typed on the node
+	bool			hasBubble = false;	//before checking for an empty comment
+	int32			commentSize = 18;
+	int32			posX = 0;		//in graph units
+	int32			posY = 0;
+	int32			width = 0;
+	int32			height = 0;
+	bool			canAddPin = false;
+	TArray<int32>		inputs;			//the pins with a row, in graphIR::pins
+	TArray<int32>		outputs;		//..not including delegates
+	TMap<FString, FString>	visiblePins;		//if empty, all pins are visible
+};
+
+/**
+ * @brief A graph, copied out of its UEdGraph into plain data.
+ *
+ * reporter::extractGraph() reads the graph, its nodes and its pins, which has
+ * to be done on the game thread, and fills one of these in.  The render side
+ * (reporter::renderGraph() and what it calls) only reads from it, so the
+ * text no longer depends on the UObjects still being around, or on which
+ * thread writes it.
+ */
+
+struct graphIR
+{
+	FString			name;
+	FString			qualifier;		//Blueprint, Material..
+	FString			brief;			//from the node that collapsed this graph, if any
+	FString			details;		//the graph's own description
+	FString			cpp;			//its fake C++, from reporter::getGraphCPP()
+	TArray<graphNode>	nodes;			//in graph order
+	TArray<graphPin>	pins;
+	TArray<graphEdge>	edges;			//in the order they were found
+};
@@ -4,6 +4,25 @@
 
 #include "reporter.h"
 
+/**
+ * @brief Everything written in a material's class header.
+ *
+ * Filled either from a loaded material, or from asset registry tags when
+ * reporting an index (see reporter::IndexOnly).
+ */
+
+struct materialHeaderData
+{
+	FString		className;
+	FString		parentClass;
+	FString		packageName;
+	FString		brief;
+	FString		imageTag;
+	FString		config;
+	FString		domain;
+	FString		description;
+};
+
 class materialReporter : public reporter
 {
 public:
@@ -17,6 +36,7 @@ protected:
 	virtual void LOG(FString verbosity,FString message) override;
 
 	virtual int reportMaterial(FString prefix, UMaterialInterface* materialInterface) override;
+	virtual int reportMaterialIndex(FAssetData const& Asset);
 	virtual void reportGraph(FString prefix, UEdGraph* g) override;
 	virtual void reportNode(FString prefix, UEdGraphNode* Node) override;
 
@@ -39,5 +59,6 @@ private:
 		FString imageTag,
 		int graphCount
 	);
+	void writeMaterialHeader(materialHeaderData const& header, FString group, FString qualifier);
 	void writeMaterialMembers(UMaterial* material, FString what);
 };
@@ -0,0 +1,60 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include <iostream>
+
+#include "CoreMinimal.h"
+
+class fileWriter;
+
+/**
+ * @brief Where a reporter writes its fake C++.
+ *
+ * A file is built up in memory as UTF-8 and written in one go when it is
+ * closed, so `endl` no longer flushes (or makes a syscall) per line.  Given
+ * a fileWriter, the write is handed to it, and done in the background.
+ *
+ * A file whose bytes haven't changed since the last run is left alone, so
+ * its timestamp doesn't change either, and doxygen (and anything else
+ * downstream) only sees the files that did (see fileWriter::writeFile).
+ *
+ * Stdout (`-OutputDir=-`) goes through the same interface, a line at a time,
+ * so it stays in order with the log.
+ *
+ * It takes the same `<<` as the std::wostream it replaced:
+ * `*out << *prefix << "text" << count << endl;`
+ *
+ * \sa reporter::openFile
+ */
+
+class outputSink
+{
+public:
+	outputSink();
+	virtual ~outputSink();
+
+	bool open(FString _path, bool _append = false, fileWriter* _writer = NULL);
+	void openStdout();
+	bool close();
+
+	bool isFile() const			{ return !path.IsEmpty(); }
+	FString getPath() const		{ return path; }
+
+	outputSink& operator<<(const TCHAR* s);
+	outputSink& operator<<(const ANSICHAR* s);
+	outputSink& operator<<(FString const& s);
+	outputSink& operator<<(int32 v);
+	outputSink& operator<<(std::wostream& (*manip)(std::wostream&));	//endl
+
+protected:
+	void append(const TCHAR* s, int32 len);
+	void newline();
+
+private:
+	FString			path;				//empty for stdout
+	bool			appendToFile = false;
+	fileWriter*		writer = NULL;			//writes the file in the background, or NULL to write it on close()
+	TArray<uint8>	buffer;				//the file so far, as UTF-8
+	FString			line;				//the stdout line so far
+};
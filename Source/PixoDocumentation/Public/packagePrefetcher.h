@@ -0,0 +1,60 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AssetRegistry/AssetData.h"
+
+/**
+ * @brief Loads packages ahead of the report loop.
+ *
+ * Reporters walk their (already filtered) asset list through next(), which
+ * hands back assets in their original order, once their packages have
+ * loaded.  Up to `window` LoadPackageAsync() requests are kept in flight, so
+ * disk reads and deserialization of the next assets overlap with the
+ * emission of the current one.
+ *
+ * Packages are requested with the same LOAD_NoWarn | LOAD_DisableCompileOnLoad
+ * flags the reporters pass to StaticLoadObject(), since that call only finds
+ * the package we already loaded.  UE4's LoadPackageAsync() takes no load
+ * flags, so there prefetching is always off.
+ *
+ * A window of 0 turns prefetching off, and assets are handed back in order
+ * for a plain synchronous StaticLoadObject().
+ *
+ * Packages that finish loading are rooted until next() hands them back, so
+ * a garbage collection between assets can't throw away the window.
+ *
+ * \sa reporter::PrefetchWindow
+ */
+
+class packagePrefetcher
+{
+public:
+	packagePrefetcher(TArray<FAssetData> const& _assets, int32 _window);
+	virtual ~packagePrefetcher();
+
+	bool next(FAssetData& asset);
+	void flush();
+
+protected:
+	struct request
+	{
+		int32	index = INDEX_NONE;		//index into assets
+		int32	requestId = INDEX_NONE;		//from LoadPackageAsync()
+		bool	done = false;
+		bool	succeeded = false;
+		UPackage* package = NULL;		//rooted by us until handed back
+	};
+
+	void release(TSharedPtr<request>& r);
+
+	virtual void issue();
+
+private:
+	TArray<FAssetData>		assets;
+	int32				window = 0;
+	int32				nextIndex = 0;		//the next asset to request (or return, when not prefetching)
+
+	TArray<TSharedPtr<request>>	inflight;
+};
@@ -0,0 +1,89 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AssetRegistry/AssetData.h"
+
+/**
+ * @brief The record of what each package produced in the output directory.
+ *
+ * Saved as json in the output directory between runs.  Each package maps to
+ * the hash of its .uasset file, the files written for it, and its gallery
+ * entries.  A package whose hash still matches is not loaded or emitted
+ * again; its gallery entries are simply handed back to the group.
+ *
+ * The plugin version and stylesheet are stored with the manifest, and a
+ * change to either regenerates everything.
+ *
+ * Every discovered package is tracked, even those in another shard, so that
+ * a change can invalidate the packages that reference it (see refresh() and
+ * forceDirty()).  Hashing reads the whole package, so the hash is only
+ * recomputed when the file's size or timestamp has changed.
+ *
+ * \sa reporter::Manifest
+ */
+
+class reportManifest
+{
+public:
+	reportManifest(FString _path, FString _outputDir, FString _stylesheet);
+	virtual ~reportManifest();
+
+	bool load();
+	bool save();
+
+	//lookups, before loading
+	bool refresh(FName packageName);
+	void forceDirty(FName packageName);
+	bool isUpToDate(FAssetData const& asset);
+	TArray<FString> getGallery(FName packageName) const;
+
+	//recording, while emitting
+	void begin(FName packageName);
+	void addFile(FString fpath);
+	void addGallery(FString galleryEntry);
+	void finish(bool upToDate = true);
+	void cancel();
+	bool invalidateFile(FString fpath);
+
+	int32 prune(TSet<FName> const& discovered, TArray<FName>& removed);
+
+	void setFull(bool _full)		{ full = _full; }
+	bool isIncremental() const		{ return loaded && !full; }
+
+	int32 getNumUnchanged() const		{ return numUnchanged; }
+	int32 getNumDeleted() const		{ return numDeleted; }
+
+	static FString getPackageFilename(FName packageName);
+
+protected:
+	struct entry
+	{
+		FString			hash;			//the file hash when last emitted completely, or empty
+		FString			fileHash;		//the file hash when last seen
+		int64			size = -1;		//..and its size and timestamp
+		FDateTime		timestamp;
+		bool			refreshed = false;	//fileHash is current for this run
+		TArray<FString>		files;			//relative to outputDir
+		TArray<FString>		gallery;
+	};
+
+	FString getRelativePath(FString fpath) const;
+	bool deleteFile(FString relPath);
+
+private:
+	FString			path;				//the manifest file
+	FString			outputDir;
+	FString			stylesheet;
+	FString			version;			//plugin VersionName
+	bool			full = false;			//ignore what was recorded, and regenerate everything
+	bool			loaded = false;			//a manifest from the last run was read
+
+	TMap<FName, entry>	entries;
+	FName			current;			//the package being emitted
+	TArray<FString>		previousFiles;			//what current produced last time
+
+	int32			numUnchanged = 0;
+	int32			numDeleted = 0;
+};
@@ -24,8 +24,34 @@ using namespace DocUtils;
 
 #include "Kismet2/BlueprintEditorUtils.h"
 
+#include "folderTrie.h"
+#include "outputSink.h"
+#include "fileWriter.h"
+#include "graphIR.h"
+
 DEFINE_LOG_CATEGORY_STATIC(LOG_DOT, Log, All);
 
+class packagePrefetcher;
+class reportManifest;
+class FObjectThumbnail;
+class galleryAtlas;
+
+/**
+ * @brief A doxygen group and its gallery, as written to the groups file.
+ *
+ * Groups are collected in reporter::GroupList during a run and written once
+ * at the end, or saved as shard state when the run is sharded.
+ */
+
+struct reportGroupData
+{
+	FString			name;
+	FString			namePretty;
+	FString			brief;
+	FString			details;
+	TArray<FString>		gallery;		//image entries, sorted when formatted
+};
+
 /**
  * @brief The reporter base class
  *
@@ -44,17 +70,27 @@ public:
 	reporter(FString type, FString _outputDir, FString _stylesheet, FString _groups);
 	virtual ~reporter();
 
-#if ENGINE_MAJOR_VERSION >= 5
-	virtual void loadAssetsByPath(FTopLevelAssetPath loadPath);	//UE5.1
-#else
-	virtual void loadAssets(FName loadClass);		//UE4.27
-#endif
+	virtual void setAssetList(TArray<FAssetData> const& assets);	//discovered once by PixoDocumentation
 
 	virtual void report(int &graphCount, int &ignoredCount, int &failedCount);
 
-	static TArray<FString>		GroupList;		//the list of groups reported
+	static void compileFolders();
+	static FString formatGroup(reportGroupData const& group, galleryAtlas const* atlas = NULL);
+	static reportGroupData* findGroup(FString groupName);
+
+	static TArray<reportGroupData>	GroupList;		//the list of groups reported
 	static TArray<FString>		IgnoreFolders;		//folders to ignore
 	static TArray<FString>		IncludeFolders;		//folders to include
+	static folderTrie		Folders;		//both of the above, compiled by compileFolders()
+	static int32			PrefetchWindow;		//packages loaded ahead of the report loop (0 = off)
+	static int32			MemoryBudgetMB;		//collect garbage between assets above this (0 = off)
+	static uint64			PeakMemoryMB;		//highest resident memory seen between assets
+	static int32			NumGCPasses;		//garbage collections run because of MemoryBudgetMB
+	static TArray<TWeakObjectPtr<UPackage>>	ReleasedPackages;	//finished packages, detached from their loaders at the next collection
+	static reportManifest*		Manifest;		//what the last run produced, or NULL to regenerate everything
+	static fileWriter*		Writer;			//writes finished files in the background, or NULL to write them on close
+	static FString			ThumbnailCacheDir;	//encoded thumbnails, kept between runs (empty = off)
+	static bool			IndexOnly;		//headers from asset registry tags, without loading (-OutputMode=index)
 
 protected:
 	FName				reportClassName;
@@ -64,14 +100,17 @@ protected:
 	FString				outputDir = "-";	//use "-" for stdout
 	FString				currentDir = "";
 
-	TArray<FAssetData>		assetList;
+	TArray<FAssetData>		assetList;		//shared discovery results, see PixoDocumentation::discoverAssets()
 
-	vmap				NodeStyle;
+	styleSlots			BaseStyle;		//style defaults, set once in the constructor
+	styleSlots			NodeStyle;		//per node values, over BaseStyle
 
 	TMap<UEdGraph*, FString>	GraphDescriptions;	//assuming parent graphs are parsed before children.  This is the description provided in the collapse node of the parent.
 	TMap<FString, TArray<FString>>	GraphCalls;		//any node (url) mentioned in a graph is appended to the call graph.
 	TArray<FString>			GalleryList;		//list of image entries for the gallery.  Should be cleared before each group (Blueprint/Material/etc.)
-	TMap<FString, FString>		pinConnections;		//intended to be [SOURCE:port:_ -- DEST:port:_] [color], which forces uniqueness of connections despite direction
+	graphIR				Graph;			//the graph being reported, as plain data.  See extractGraph()
+	TMap<UEdGraphNode*, int32>	NodeIndex;		//where each of its nodes went in Graph, while extracting
+	TMap<UEdGraphPin*, int32>	PinIndex;		//..and each visible pin
 
 	virtual void LOG(FString message);
 	virtual void LOG(FString verbosity,FString message);
@@ -80,25 +119,50 @@ protected:
 	virtual bool shouldReportObject(UObject* object);
 
 	virtual bool createThumbnailFile(UObject* object, FString pngPath);
+	virtual bool createThumbnailFile(FAssetData const& Asset, FString pngPath);
+	virtual bool writeThumbnail(FObjectThumbnail& Thumb, FString pngPath, FString cachePath);
+	virtual bool writePng(TArray<uint8> png, FString pngPath);
+	virtual void addOutputFile(FString fpath);
+
+	virtual FString getThumbnailCachePath(FName packageName, FString fullName);
+	virtual bool readThumbnailCache(FString cachePath, FString pngPath, bool& hasThumbnail);
+	static void writeThumbnailCache(FString cachePath, TArray<uint8> const& png);
+	static bool readThumbnailTableOffset(FString filename, int64& offset);
+	static bool encodePng(TArray<uint8> const& bgra, int32 w, int32 h, TArray<uint8>& png);
+
+	virtual bool setCurrentDir(FString packageName);
+
+	virtual void trackMemory(packagePrefetcher& prefetcher, UPackage* finished);
+	static void releasePackage(UPackage* package);
 
 	virtual int reportBlueprint(FString prefix, UBlueprint* Blueprint);
 	virtual int reportMaterial(FString prefix, UMaterialInterface* materialInterface);
 	virtual void reportGroup(FString groupName, FString groupNamePretty, FString brief, FString details);
+	virtual void addGalleryEntry(FString galleryEntry);
+	virtual bool skipUnchanged(FAssetData const& Asset);
 
 	virtual void reportGraph(FString prefix, UEdGraph* g);
 	virtual void reportNode(FString prefix, UEdGraphNode* Node);
-	virtual void writeNodeBody(FString prefix, UEdGraphNode *node);
+
+	//extract: UEdGraph -> graphIR, on the game thread
+	virtual void extractGraph(UEdGraph* g, FString qualifier);
+	virtual void extractNodes(UEdGraph* g);
+	virtual void extractPins(UEdGraph* g);
+	graphNode& extractNode(UEdGraphNode* node);
+	FLinearColor getNodeTitleColor(UEdGraphNode* node);
 
 	virtual FString getGraphCPP(UEdGraph* graph, FString _namespace="");
 	virtual bool getNodeHasBubble(UEdGraphNode *node);
 	virtual FString getNodeTitle(UEdGraphNode *node, FString &title2);
 	virtual TMap<FString, FString> getVisiblePins(UEdGraphNode* node);
 
-	virtual void writeGraphHeader(FString prefix, UEdGraph* graph, FString qualifier);
-	virtual void writeGraphFooter(FString prefix, UEdGraph *graph);
-	virtual void writeGraphConnections(FString prefix);
-
-	virtual FString prepNodePortRows(FString prefix, UEdGraphNode* node, TMap<FString, FString> visiblePins = TMap<FString, FString>());
+	//render: graphIR -> text, without touching a UObject
+	virtual void renderGraph(FString prefix, graphIR const& graph);
+	virtual void writeGraphHeader(FString prefix, graphIR const& graph);
+	virtual void writeGraphFooter(FString prefix, graphIR const& graph);
+	virtual void writeGraphConnections(FString prefix, graphIR const& graph);
+	virtual void writeNodeBody(FString prefix, graphIR const& graph, graphNode const& node);
+	virtual FString prepNodePortRows(FString prefix, graphIR const& graph, graphNode const& node);
 
 	virtual void writeAssetFooter();
 	virtual void writeAssetCalls(FString className);
@@ -116,8 +180,8 @@ protected:
 	float		_dpi = 96.0f;				// dpi scaling, but only for POS, not SIZE
 	float		_scale = 72.0f / 96.0f;			// scaling for width and height, which are presented in different DPI
 
-	std::wostream	*out = NULL;				// our output stream, which will default to std::wcout
-	std::wofstream	*outfile = NULL;			// our output file, which will default to NULL unless opened
+	outputSink	*out = NULL;				// our output, once a file (or stdout) is opened
+	outputSink	output;
 
 private:
 	//verbose only
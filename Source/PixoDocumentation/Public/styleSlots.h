@@ -0,0 +1,112 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief The template slots.
+ *
+ * Each is written as "_NAME_" in a template, eg: StyleKey::NODETITLE is
+ * "_NODETITLE_".  See styleSlots::getName().
+ */
+
+enum class StyleKey : uint8
+{
+	//style, set once by the reporter
+	STYLESHEET = 0,
+	GRAPHBG,
+	FONTNAME,
+	FONTSIZE,
+	FONTSIZE2,
+	FONTCOLOR,
+	FONTSIZEPORT,
+	FONTSIZECOMMENT,
+	FONTSIZEBUBBLE,
+	FONTCOLORBUBBLE,
+	NODECOLOR,
+	NODECOLORTRANS,
+	VALCOLOR,
+	BORDERCOLOR,
+	EDGECOLOR,
+	EDGETHICKNESS,
+	PINDEFAULTCOLOR,
+	PINURL,
+	CELLPADDING,
+	COMMENTPADDING,
+	COMPOSITEPADDING,
+	COMPACTCOLOR,
+	COMPACTSIZE,
+	COMPACTWIDTH,
+	HEIGHTSPACER,
+
+	//per node
+	NODENAME,
+	NODEGUID,
+	NODEICON,
+	NODEDELEGATE,
+	NODETITLE,
+	NODETITLE2,
+	NODECOMMENT,
+	POS,
+	WIDTH,
+	HEIGHT,
+	TOOLTIP,
+	HEADERCOLOR,
+	HEADERCOLORDIM,
+	HEADERCOLORLIGHT,
+	HEADERCOLORTRANS,
+	HEADERTEXTCOLOR,
+	CLASS,
+	URL,
+	PORTROWS,
+
+	//per pin row
+	PINCOLOR,
+	INPORT,
+	INICON,
+	INLABEL,
+	INCOLOR,
+	INVALUE,
+	INTOOLTIP,
+	OUTPORT,
+	OUTICON,
+	OUTLABEL,
+	OUTCOLOR,
+	OUTVALUE,
+	OUTTOOLTIP,
+
+	MAX
+};
+
+/**
+ * @brief Values for the template slots, indexed by StyleKey.
+ *
+ * A layer holds only the slots set on it, and falls back to its base for
+ * the rest.  The reporter's defaults are one layer, which doesn't change
+ * after construction.  The per node values are a layer on top of that, and
+ * the pin data for a row is a layer on top of the node.
+ *
+ * Setting a slot is an indexed store, with no hashing.
+ *
+ * \sa compiledTemplate
+ */
+
+class styleSlots
+{
+public:
+	styleSlots(styleSlots const* _base = NULL);
+	virtual ~styleSlots();
+
+	void set(StyleKey key, FString value);
+	const FString* find(StyleKey key) const;
+	void reset();
+
+	static StyleKey findKey(FString const& name);
+	static const TCHAR* getName(StyleKey key);
+
+private:
+	styleSlots const*	base;
+	uint64			isSet = 0;				//a bit per StyleKey
+	FString			values[(int32)StyleKey::MAX];
+};
@@ -0,0 +1,48 @@
+// (c) 2023 PixoVR
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * @brief A tar file that output is streamed into, for `-OutputArchive`.
+ *
+ * Each file is appended as an entry as soon as it is written, named by its
+ * path under the output directory, so no directory tree is made on disk.
+ * Names longer than a tar header holds use a GNU long name entry, which
+ * GNU tar and bsdtar both read.
+ *
+ * Entries can be added from any thread (see fileWriter), one at a time.
+ *
+ * \sa fileWriter::Archive
+ */
+
+class tarArchive
+{
+public:
+	tarArchive(FString _path, FString _root);
+	virtual ~tarArchive();
+
+	bool open();
+	bool close();
+
+	bool add(FString fpath, const uint8* data, int64 size);
+
+	FString getPath() const		{ return path; }
+	int32 getNumEntries() const	{ return numEntries; }
+
+protected:
+	bool writeHeader(FString const& name, int64 size, ANSICHAR type);
+	bool writePadded(const uint8* data, int64 size);
+
+	static void setOctal(ANSICHAR* field, int32 width, int64 value);
+
+private:
+	FString			path;				//the .tar file
+	FString			root;				//output paths are named relative to this
+	FArchive*		file = NULL;
+	FCriticalSection	lock;
+	int32			numEntries = 0;
+	int64			timestamp = 0;			//for every entry, from open()
+};